@@ -1,226 +1,3130 @@
 #include <linux/init.h>
 #include <linux/module.h>
 #include <linux/kernel.h>
-#include <linux/gpio.h>
+#include <linux/platform_device.h>
+#include <linux/of.h>
+#include <linux/property.h>
+#include <linux/idr.h>
+#include <linux/kref.h>
+#include <linux/gpio/consumer.h>
+#include <linux/bitmap.h>
 #include <linux/interrupt.h>
-#include <linux/timer.h>
-#include <linux/mutex.h>
+#include <linux/irqdesc.h>
+#include <linux/pwm.h>
+#include <linux/spi/spi.h>
+#include <linux/workqueue.h>
+#include <linux/hrtimer.h>
+#include <linux/moduleparam.h>
+#include <linux/seqlock.h>
+#include <linux/ktime.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <linux/fs.h>
+#include <linux/miscdevice.h>
+#include <linux/mm.h>
+#include <linux/vmalloc.h>
+#include <linux/uaccess.h>
+#include <linux/kfifo.h>
+#include <linux/list.h>
+#include <linux/rculist.h>
+#include <linux/poll.h>
+#include <linux/wait.h>
+#include <linux/percpu.h>
+#include <linux/log2.h>
+#include <linux/sched/clock.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/jump_label.h>
+#include <linux/math.h>
+#include <linux/pm.h>
+#include <linux/pm_runtime.h>
 
-#define NUM_LEDS 4
+#include "ledctl.h"
+
+#define CREATE_TRACE_POINTS
+#include "led_trace.h"
+
+#define LED_MAX_LEDS LEDCTL_MAX_LEDS  // 패널당 LED 수 상한 (leds-gpios, registers-number, led-count)
 #define NUM_SWITCHES 4
-#define DEBOUNCE_DELAY (HZ / 5)  // 200ms 디바운스 시간
-
-static int led_pins[NUM_LEDS] = {23, 24, 25, 1};
-static int switch_pins[NUM_SWITCHES] = {4, 17, 27, 22};
-static int irq_numbers[NUM_SWITCHES];
-static bool led_states[NUM_LEDS] = {false, false, false, false};
-static unsigned long last_switch_time[NUM_SWITCHES] = {0, 0, 0, 0};
-
-static int current_mode = -1; 
-static int direction = 0;     
-static int current_led = 0;
-static struct timer_list led_timer;
-static struct mutex mode_lock;
-
-static void reset_leds(void);
-static void set_led(int led_idx, int value);
-static irqreturn_t switch_handler(int irq, void *dev_id);
-static void led_timer_callback(struct timer_list *timer);
-
-static void reset_leds(void) {
+#define DEBOUNCE_DEFAULT_US (20 * USEC_PER_MSEC)  // 20ms 디바운스 시간
+#define DEBOUNCE_MIN_US USEC_PER_MSEC   // 누른 채 폴링하므로 너무 짧으면 hardirq 폭주
+#define DEBOUNCE_MAX_US USEC_PER_SEC
+#define TICK_PERIOD_MIN_US 100
+#define TICK_PERIOD_MAX_US (60 * USEC_PER_SEC)
+#define LED_BRIGHTNESS_MAX 255
+#define PWM_PERIOD_NS (10 * NSEC_PER_MSEC)  // 소프트웨어 PWM 주기 10ms (100Hz)
+#define LED_PATTERN_MAX_STEPS 64
+#define LED_COLOR_WHITE 0xffffff
+#define FADE_MAX_US (10 * USEC_PER_SEC)
+#define FADE_ONE 256               // 페이드 진행도 고정소수점 (8비트 소수)
+#define WS2812_SPI_HZ 2400000      // 데이터 비트 하나 = SPI 3비트 (1.25us)
+#define WS2812_BYTES_PER_LED 9     // G, R, B 각 8비트 x 3
+#define WS2812_RESET_BYTES 90      // 280us 이상 low 로 래치 (신형 WS2812B 기준)
+#define LED_MODE_STREAM 4  // /dev/ledctlN 프레임 링 재생
+#define LEDCTL_EVENT_QUEUE 64  // open 당 이벤트 큐 길이 (2의 거듭제곱)
+#define LED_CMD_QUEUE 32       // 제어 명령 링 길이 (2의 거듭제곱)
+#define LED_CMD_LATENCY_US (10 * USEC_PER_MSEC)  // 다음 틱이 이보다 멀면 cmd_work 가 바로 적용
+#define LED_WAKE_MS 1000  // 스위치로 깨어난 뒤 사용자 공간이 이벤트를 읽을 때까지 잠들지 않음
+#define LED_AUTOSUSPEND_MS 5000  // 유휴가 이만큼 이어지면 런타임 suspend (sysfs 의 autosuspend_delay_ms)
+#define LED_HIST_BUCKETS 32    // 처리 시간 log2 히스토그램: 버킷 k 는 [2^k, 2^(k+1)) ns
+
+struct led_panel;
+
+// 스위치 하나: 디바운스는 컨트롤러가 지원하면 하드웨어, 아니면 IRQ 를 끄고 hrtimer 로 재확인
+// 스위치마다 IRQ 가 다른 CPU 로 갈 수 있으므로 한 스위치가 캐시 라인 하나를 단독으로 사용
+struct led_switch {
+    struct led_panel *panel;
+    struct gpio_desc *desc;
+    struct hrtimer debounce_timer;
+    ktime_t last_time;  // 하드 IRQ 상단부에서만 기록
+    unsigned long inject;  // 비트 0: debugfs 로 주입한 엣지 (디바운스 레벨 검사 통과)
+    unsigned long wake;    // LED_SW_WAKE_*
+    int id;
+    int irq;
+    bool hw_debounce;   // gpiod_set_debounce 성공
+    bool pressed;       // 디바운스 콜백이 마지막으로 샘플한 안정 레벨 (콜백만 기록)
+    bool wake_armed;    // 시스템 suspend 동안 enable_irq_wake 상태
+} ____cacheline_aligned_in_smp;
+
+enum {
+    LED_SW_WAKE_REPORTED,  // 이번 누름의 깨움 이벤트를 이미 보고 (바운스 엣지는 다시 보고하지 않음)
+    LED_SW_WAKE_PENDING,   // 시스템 suspend 중에 눌림: resume 에서 한 번 처리
+};
+
+// 패턴 한 단계: SET 은 마스크를 그대로 출력, XOR 는 현재 상태에서 마스크 비트를 반전
+// 모든 연산이 워드 단위 비트맵 연산이라 LED 수가 늘어도 단계 비용은 거의 일정
+enum led_step_op {
+    LED_OP_SET,
+    LED_OP_XOR,
+    LED_OP_ROTATE,  // 현재 상태 전체를 shift 만큼 회전 (마스크 미사용)
+};
+
+struct led_step {
+    u8 op;
+    s16 shift;                       // ROTATE: 위쪽(+)/아래쪽(-)으로 회전할 LED 수
+    u32 duration_us;                 // 0 이면 tick_period_us 사용
+    DECLARE_BITMAP(mask, LED_MAX_LEDS);
+};
+
+struct led_pattern {
+    int len;
+    int loop;                        // 마지막 단계 다음에 돌아갈 단계 (len 이면 한 번만 재생)
+    bool ordered;                    // 단계를 논리 순서(state->chase)에 적용하고 panel->order 로 출력
+    struct led_step steps[LED_PATTERN_MAX_STEPS];
+};
+
+enum {
+    LED_PAT_BLINK,       // 모드 0: 전체 점멸
+    LED_PAT_CHASE_DOWN,  // 모드 1, direction 0
+    LED_PAT_CHASE_UP,    // 모드 1, direction 1
+    LED_PAT_MANUAL,      // 모드 2: 전체 토글
+    LED_PAT_USER,        // 모드 3: 사용자 업로드 패턴
+    LED_NUM_PATTERNS,
+};
+
+// 모드/LED 상태: panel->lock 으로 보호 (쓰기는 스핀, 읽기는 lockless)
+struct led_state {
+    int mode;
+    int direction;
+    const struct led_pattern *pattern;  // NULL 이면 타이머 정지
+    int step;                           // 다음에 출력할 단계
+    int still;                          // 반복 구간에서 출력이 바뀌지 않은 연속 단계 수
+    DECLARE_BITMAP(leds, LED_MAX_LEDS);
+    DECLARE_BITMAP(chase, LED_MAX_LEDS);  // ordered 패턴의 논리 순서 상태
+};
+
+// 소프트웨어 PWM: 같은 듀티의 LED 를 하나의 엣지로 묶어 듀티 순으로 나열
+struct pwm_edge {
+    u8 duty;
+    u32 offset_ns;                   // 주기 시작 기준 소등 시각
+    DECLARE_BITMAP(off, LED_MAX_LEDS);  // 이 엣지에서 꺼지는 LED
+};
+
+struct led_pwm {
+    struct pwm_edge *edges;          // min(num_leds, LED_BRIGHTNESS_MAX - 1) 개 할당
+    u8 slot[LED_BRIGHTNESS_MAX + 1]; // 듀티 -> edges 인덱스 (재구성 중에만 유효)
+    int num_edges;                   // 0 이면 PWM 타이머 정지
+    int next_edge;                   // num_edges 이면 다음은 주기 시작
+    ktime_t period_start;
+    DECLARE_BITMAP(on_mask, LED_MAX_LEDS);  // 밝기가 0 이 아닌 LED
+    DECLARE_BITMAP(phase, LED_MAX_LEDS);    // 현재 PWM 위상에서 켜져 있는 LED
+};
+
+// 페이드: 출력 비트맵이 바뀌면 LED 별 밝기를 duration_us 동안 보간 (0 이면 즉시 전환)
+// 보간은 지각 밝기 (감마 적용 전) 공간에서 하고 LED 마다 감마 표로 듀티 변환
+// 프레임은 PWM 타이머의 주기 시작마다 계산하므로 페이드 중에는 PWM 타이머가 계속 돎
+struct led_fade {
+    u8 *from;                           // 시작 지각 밝기 (num_leds 개 할당)
+    u8 *to;                             // 목표 지각 밝기 (num_leds 개 할당)
+    DECLARE_BITMAP(target, LED_MAX_LEDS);  // 목표를 계산할 때의 state.leds
+    ktime_t start;
+    unsigned int duration_us;           // sysfs fade_us
+    bool active;
+};
+
+// 하드웨어 PWM 채널: pwm_get 이 con_id 포인터를 라벨로 보관하므로 이름도 함께 유지
+struct led_hwpwm_chan {
+    struct pwm_device *pwm;             // NULL 이면 GPIO + 소프트웨어 PWM
+    char name[8];                       // pwm-names 의 "ledN"
+};
+
+// 하드웨어 PWM 으로 넘긴 LED: pwm_apply_state 가 sleep 할 수 있어 워크에서 적용
+struct led_hwpwm {
+    struct led_hwpwm_chan *chan;        // num_leds 개 할당
+    DECLARE_BITMAP(mask, LED_MAX_LEDS);
+    DECLARE_BITMAP(last, LED_MAX_LEDS); // 마지막으로 워크에 넘긴 점등 상태
+    struct work_struct work;
+};
+
+// LED 출력 백엔드: commit 은 led_flush 에서 한 번에 하나씩, 하드 IRQ 에서도 호출되므로 sleep 금지
+struct led_output_ops {
+    const char *name;
+    bool rgb;                           // commit 이 LED 별 색과 밝기를 직접 인코딩 (소프트웨어 PWM 없음)
+    int (*count)(struct device *dev);   // 펌웨어 노드에서 읽은 LED 수
+    int (*setup)(struct led_panel *panel);
+    void (*release)(struct led_panel *panel);
+    void (*commit)(struct led_panel *panel, const unsigned long *out);
+};
+
+// SPI 백엔드 공통 (74HC595, WS2812, APA102): 버퍼 두 개를 번갈아 전송
+// encode 는 프레임 전체를 전송 버퍼 하나에 써 넣음 (o->lock 보유, sleep 금지)
+struct led_spi_out {
+    struct spi_device *spi;
+    struct spi_message msg;
+    struct spi_transfer xfer;
+    u8 *buf[2];              // DMA 가능한 kmalloc 버퍼
+    int active;              // 전송 중이거나 마지막으로 보낸 버퍼
+    bool busy;               // spi_async 가 끝나지 않음
+    bool pending;            // 전송 중에 다른 버퍼에 새 프레임이 준비됨
+    size_t len;              // 레지스터 수 (바이트)
+    spinlock_t lock;         // 완료 콜백과 커밋 사이의 버퍼 교대 보호
+    wait_queue_head_t idle;
+    void (*encode)(struct led_panel *panel, const unsigned long *out, u8 *buf);
+};
+
+// 진단 통계 (debugfs 의 diagnostics 를 켰을 때만 수집)
+// CPU 마다 따로 세어 IRQ 와 타이머 컨텍스트가 캐시 라인을 공유하지 않음
+// debugfs 에서 읽을 때만 합산 (32비트에서는 합산 중 값이 찢어질 수 있으나 통계용이라 허용)
+struct led_stats {
+    u64 irqs[NUM_SWITCHES];
+    u64 debounce_drops[NUM_SWITCHES];
+    u64 ticks;
+    u64 pwm_ticks;
+    u64 tick_late_sum_ns;
+    u64 tick_late_max_ns;
+    u64 irq_hist[LED_HIST_BUCKETS];     // 하드 IRQ 상단부
+    u64 thread_hist[LED_HIST_BUCKETS];  // 스레드 핸들러
+    u64 tick_hist[LED_HIST_BUCKETS];    // 패턴 한 단계 (틱 콜백)
+    u64 press_hist[LED_HIST_BUCKETS];   // 스위치 엣지부터 출력 커밋까지 (디바운스 포함)
+};
+
+// 완성된 출력 프레임 하나 (삼중 버퍼의 한 칸)
+// 칸마다 캐시 라인을 따로 써서 채우는 쪽(lock 보유자)과 출력하는 쪽이 같은 라인을 두고 다투지 않음
+struct led_frame {
+    DECLARE_BITMAP(bits, LED_MAX_LEDS);
+} ____cacheline_aligned_in_smp;
+
+#define LED_FRAME_DIRTY 1UL  // frame_mid 에 아직 출력하지 않은 프레임이 있음
+
+enum {
+    LED_KICK_TIMER,  // led_timer
+    LED_KICK_PWM,    // pwm_timer
+};
+
+// 사용자 공간 제어 명령 (ioctl, sysfs): 생산자는 링에 넣기만 하고 틱 시작에서 한꺼번에 적용
+enum led_cmd_op {
+    LED_CMD_MODE,       // arg: 모드 0-3 (스위치와 같은 동작)
+    LED_CMD_DIRECTION,  // arg: 개별 모드 방향 (0: 아래로, 1: 위로)
+    LED_CMD_PATTERN,    // pat: 사용자 패턴, 적용한 쪽이 해제
+    LED_CMD_STREAM,     // arg: 1 이면 링 재생 시작, 0 이면 정지
+};
+
+struct led_cmd {
+    u32 op;
+    u32 arg;
+    struct led_pattern *pat;
+};
+
+// Device Tree 노드 하나당 패널 하나: 상태, 타이머, 락이 모두 인스턴스별
+// 쓰는 컨텍스트별로 캐시 라인을 나눔: 읽기 위주 설정 / 틱(lock 보유자) / 출력(led_flush) / 스위치 IRQ
+struct led_panel {
+    // 읽기 위주: probe 이후 거의 바뀌지 않음 (sysfs 로만 변경)
+    struct device *dev;
+    int id;
+    int num_leds;            // leds-gpios 개수 (1 - LED_MAX_LEDS)
+    unsigned int tick_period_us;
+    unsigned int debounce_us;
+    int cpu;                          // 스위치 IRQ 와 타이머를 고정할 CPU (-1: 고정 안 함)
+    struct led_pattern *patterns;  // LED_NUM_PATTERNS 개 할당
+    u8 *brightness;          // num_leds 개 할당
+    u8 *level;               // 실제 출력 듀티: 페이드가 없으면 brightness 와 같음 (lock 으로 보호)
+    u32 *color;              // RGB 백엔드만: LED 별 0xrrggbb (num_leds 개 할당)
+    u16 *order;              // 추적 순서: 논리 위치 i 에 놓인 LED 번호 (num_leds 개, lock 으로 보호)
+    bool ordered;            // order 가 항등 순열이 아님
+    unsigned int chase_heads;  // 추적 모드에서 같이 움직이는 LED 수
+    struct led_stats __percpu *stats;
+    const struct led_output_ops *out;
+    struct gpio_descs *led_array;  // GPIO 백엔드: leds-gpios 를 한 번에 확보했을 때 (하드웨어 PWM 없음)
+    struct gpio_desc **led_descs;  // GPIO 백엔드: 일괄 출력용 디스크립터 (GPIO 구동 LED 만)
+    int *gpio_led_map;             // led_descs[j] 가 구동하는 LED 번호
+    int num_gpio_leds;
+    struct ledctl_ring *stream_ring;  // mmap 공유 프레임 링
+    struct dentry *debugfs;
+    struct kref ref;         // probe 와 열린 /dev/ledctlN 마다 하나
+
+    // 틱 쪽: 패턴 타이머, PWM 타이머, 스위치 스레드가 lock 을 잡고 기록
+    seqlock_t lock ____cacheline_aligned_in_smp;
+    bool dead;               // remove 이후 사용자 공간 제어 거부 (lock 으로 보호)
+    struct led_state state;
+    struct led_pwm pwm;
+    struct led_fade fade;
+    struct led_hwpwm hwpwm;  // mask/last 도 lock 으로 보호
+    struct hrtimer led_timer;
+    struct hrtimer pwm_timer;
+    unsigned long kick;               // 다른 CPU 에서 시작할 타이머 (LED_KICK_*)
+    struct work_struct kick_work;
+    struct list_head sync_node;       // led_sync_panels (sync_tick 일 때)
+    bool sync_running;                // lock 과 led_sync_lock 을 모두 잡고 변경
+    ktime_t sync_due;                 // 다음 단계 예정 시각 (lock 으로 보호)
+    u32 stream_tail;                  // 커널이 가진 tail 원본 (lock 으로 보호)
+    // 전원 관리 (lock 으로 보호)
+    bool pm_busy;                     // 유휴가 아니라 런타임 PM 참조를 하나 잡고 있음
+    bool pm_parked;                   // PWM 타이머 정지 (런타임 suspend 또는 시스템 suspend)
+    bool suspended;                   // 시스템 suspend 중: 명령 워크가 적용하지 않음
+    bool pm_ticking;                  // suspend 직전에 패턴 타이머가 돌고 있었음
+    struct led_frame *frame_back;
+
+    // 출력 쪽: led_flush 와 백엔드 완료 콜백
+    // 삼중 버퍼: back 은 lock 보유자, front 는 frame_busy 보유자, mid 는 xchg 로만 교환
+    unsigned long frame_mid ____cacheline_aligned_in_smp;  // struct led_frame * | LED_FRAME_DIRTY
+    unsigned long frame_busy;         // 비트 0: led_flush 가 백엔드로 출력 중
+    struct led_frame *frame_front;
+    struct led_spi_out spi;        // SPI 백엔드 (74HC595, WS2812, APA102)
+    struct led_frame frames[3];
+
+    // 스위치 IRQ 쪽: 스위치마다 별도 캐시 라인 (struct led_switch 참고)
+    struct led_switch switches[NUM_SWITCHES];
+
+    // 드물게 바뀜: 스위치 스레드가 RCU 로 읽고 open/release 가 기록
+    struct list_head clients;         // RCU 로 순회
+    spinlock_t clients_lock;          // 목록 추가/삭제용
+    // 제어 명령 링: 꺼내는 쪽은 lock 보유자 하나뿐 (틱, 스위치 스레드, cmd_work)
+    DECLARE_KFIFO(cmds, struct led_cmd, LED_CMD_QUEUE);
+    spinlock_t cmd_lock;              // 넣는 쪽(ioctl, sysfs)끼리만 직렬화
+    struct work_struct cmd_work;      // 틱이 곧 오지 않을 때 대신 적용
+    struct miscdevice misc;
+    char misc_name[16];
+};
+
+// /dev/ledctlN 을 연 클라이언트마다 하나: 스위치 스레드가 넣고 read() 가 꺼냄
+struct ledctl_client {
+    struct led_panel *panel;
+    struct list_head node;
+    DECLARE_KFIFO(events, struct ledctl_event, LEDCTL_EVENT_QUEUE);
+    spinlock_t lock;          // 생산자(스위치 스레드)끼리만 직렬화
+    struct mutex read_lock;   // 같은 fd 의 동시 read 직렬화
+    wait_queue_head_t wait;
+    u32 dropped;              // lock 으로 보호
+    struct rcu_head rcu;
+};
+
+static DEFINE_IDA(led_panel_ida);
+
+// 새 패널의 기본 LED 틱 주기 (us), 패널별 값은 sysfs 의 tick_period_us
+static unsigned int tick_period_us = 2 * USEC_PER_SEC;
+
+static int tick_period_set(const char *val, const struct kernel_param *kp) {
+    unsigned int us;
+    int ret;
+
+    ret = kstrtouint(val, 0, &us);
+    if (ret)
+        return ret;
+    if (us < TICK_PERIOD_MIN_US || us > TICK_PERIOD_MAX_US)
+        return -EINVAL;
+
+    WRITE_ONCE(tick_period_us, us);
+    return 0;
+}
+
+static const struct kernel_param_ops tick_period_ops = {
+    .set = tick_period_set,
+    .get = param_get_uint,
+};
+module_param_cb(tick_period_us, &tick_period_ops, &tick_period_us, 0644);
+MODULE_PARM_DESC(tick_period_us, "Default LED tick period in microseconds (100 - 60000000)");
+
+// 새 패널의 기본 디바운스 구간 (us), 패널별 값은 sysfs 의 debounce_us
+static unsigned int debounce_us = DEBOUNCE_DEFAULT_US;
+
+static int debounce_set(const char *val, const struct kernel_param *kp) {
+    unsigned int us;
+    int ret;
+
+    ret = kstrtouint(val, 0, &us);
+    if (ret)
+        return ret;
+    if (us < DEBOUNCE_MIN_US || us > DEBOUNCE_MAX_US)
+        return -EINVAL;
+
+    WRITE_ONCE(debounce_us, us);
+    return 0;
+}
+
+static const struct kernel_param_ops debounce_ops = {
+    .set = debounce_set,
+    .get = param_get_uint,
+};
+module_param_cb(debounce_us, &debounce_ops, &debounce_us, 0644);
+MODULE_PARM_DESC(debounce_us, "Default switch debounce window in microseconds (1000 - 1000000)");
+
+// 모든 패널을 하나의 hrtimer 로 진행 (로드 시에만 지정, 격자 주기는 tick_period_us)
+static bool sync_tick;
+module_param(sync_tick, bool, 0444);
+MODULE_PARM_DESC(sync_tick, "Drive all panels from one shared, grid-aligned timer");
+
+// 새 패널의 스위치 IRQ/타이머와 공유 타이머를 고정할 CPU, 패널별 값은 sysfs 의 cpu
+static int led_cpu = -1;
+module_param_named(cpu, led_cpu, int, 0644);
+MODULE_PARM_DESC(cpu, "Default CPU for switch IRQs and LED timers (-1: no pinning)");
+
+static LIST_HEAD(led_sync_panels);   // RCU 로 순회
+static DEFINE_SPINLOCK(led_sync_lock);  // 목록, led_sync_users, 공유 타이머 재설정 보호
+static unsigned int led_sync_users;  // sync_running 인 패널 수
+static struct hrtimer led_sync_timer;
+static struct work_struct led_sync_kick_work;  // 공유 타이머를 led_cpu 에서 시작
+
+// 계측 빌드 (Makefile 의 LED_INSTRUMENT=y): debugfs 통계/주입, 락 검사
+// 배포 빌드에서는 아래 도우미가 모두 비어 호출 자리에 코드가 남지 않음 (tracepoint 는 NOTRACE)
+#ifdef LED_INSTRUMENT
+// 통계 수집은 기본 꺼짐, debugfs 의 led_panel/diagnostics 로 켬
+// 꺼져 있는 동안은 static key 가 분기 자리를 NOP 으로 패치해 틱/IRQ 경로에 조건 분기가 없음
+// (tracepoint 도 자체 static key 로 같은 방식)
+static DEFINE_STATIC_KEY_FALSE(led_diag_key);
+#define led_diag_on() static_branch_unlikely(&led_diag_key)
+
+static inline unsigned int led_hist_bucket(u64 ns) {
+    return min_t(unsigned int, ilog2(ns | 1), LED_HIST_BUCKETS - 1);
+}
+
+// 구간 시작 시각이 0 이면 진단이 꺼져 있을 때 시작한 구간이므로 기록하지 않음
+#define led_stat_clock() (led_diag_on() ? local_clock() : 0)
+#define led_stat_inc(panel, field)                                              \
+    do {                                                                        \
+        if (led_diag_on())                                                      \
+            this_cpu_inc((panel)->stats->field);                                \
+    } while (0)
+#define led_stat_hist(panel, hist, ns)                                          \
+    do {                                                                        \
+        if (led_diag_on())                                                      \
+            this_cpu_inc((panel)->stats->hist[led_hist_bucket(ns)]);            \
+    } while (0)
+#define led_stat_hist_since(panel, hist, t0)                                    \
+    do {                                                                        \
+        if (led_diag_on() && (t0))                                              \
+            this_cpu_inc((panel)->stats->hist[led_hist_bucket(local_clock() - (t0))]); \
+    } while (0)
+#define led_assert_locked(panel) lockdep_assert_held(&(panel)->lock.lock)
+
+// 패턴 틱 하나를 기록 (하드 IRQ 컨텍스트)
+static void __led_stat_tick(struct led_panel *panel, ktime_t due, ktime_t now, u64 t0) {
+    s64 late = ktime_to_ns(ktime_sub(now, due));
+
+    if (late < 0)
+        late = 0;
+    this_cpu_inc(panel->stats->ticks);
+    this_cpu_add(panel->stats->tick_late_sum_ns, late);
+    if (late > this_cpu_read(panel->stats->tick_late_max_ns))
+        this_cpu_write(panel->stats->tick_late_max_ns, late);
+    if (t0)
+        this_cpu_inc(panel->stats->tick_hist[led_hist_bucket(local_clock() - t0)]);
+}
+
+static inline void led_stat_tick(struct led_panel *panel, ktime_t due, ktime_t now, u64 t0) {
+    if (led_diag_on())
+        __led_stat_tick(panel, due, now, t0);
+}
+
+// 주입한 엣지는 핀 레벨과 상관없이 눌린 것으로 처리
+static inline bool led_switch_injected(struct led_switch *sw) {
+    return test_and_clear_bit(0, &sw->inject);
+}
+#else
+#define led_stat_clock() 0ULL
+#define led_stat_inc(panel, field) do { } while (0)
+#define led_stat_hist(panel, hist, ns) do { } while (0)
+#define led_stat_hist_since(panel, hist, t0) do { (void)(t0); } while (0)
+#define led_assert_locked(panel) do { } while (0)
+
+static inline void led_stat_tick(struct led_panel *panel, ktime_t due, ktime_t now, u64 t0) {
+}
+
+static inline bool led_switch_injected(struct led_switch *sw) {
+    return false;
+}
+#endif
+
+static inline ktime_t led_tick_period(struct led_panel *panel) {
+    return us_to_ktime(READ_ONCE(panel->tick_period_us));
+}
+
+static int led_set_tick_period(struct led_panel *panel, unsigned int us) {
+    if (us < TICK_PERIOD_MIN_US || us > TICK_PERIOD_MAX_US)
+        return -EINVAL;
+
+    // 다음 틱의 hrtimer_forward 부터 반영
+    WRITE_ONCE(panel->tick_period_us, us);
+    return 0;
+}
+
+static void led_commit(struct led_panel *panel);
+static void reset_leds(struct led_panel *panel);
+static void pwm_rebuild(struct led_panel *panel);
+static void pwm_apply(struct led_panel *panel);
+static void led_fade_start(struct led_panel *panel);
+static void led_select_pattern(struct led_panel *panel, int mode, const struct led_pattern *pat);
+
+// "mask[@duration_us]" 단계를 공백으로 구분, 앞에 '^' 를 붙이면 XOR 단계
+// mask 는 bitmap_parse 형식의 16진수 (예: "f@500000 0@500000")
+// ">n" / "<n" 은 현재 상태를 위/아래로 n 칸 회전하는 단계, "|" 는 반복 시작 위치
+// (맨 끝의 "|" 는 한 번만 재생하고 마지막 출력 유지)
+// (예: "1 | >1@100000" 은 LED 0 부터 위로 추적)
+static int led_pattern_parse(char *buf, struct led_pattern *pat, int num_leds) {
+    char *tok, *dur;
+    int ret;
+
+    pat->len = 0;
+    pat->loop = 0;
+    while ((tok = strsep(&buf, " \t\n")) != NULL) {
+        struct led_step *step;
+
+        if (!*tok)
+            continue;
+        if (!strcmp(tok, "|")) {
+            pat->loop = pat->len;
+            continue;
+        }
+        if (pat->len >= LED_PATTERN_MAX_STEPS)
+            return -E2BIG;
+
+        step = &pat->steps[pat->len];
+        step->op = LED_OP_SET;
+        step->shift = 0;
+        if (*tok == '^') {
+            step->op = LED_OP_XOR;
+            tok++;
+        } else if (*tok == '>' || *tok == '<') {
+            step->op = LED_OP_ROTATE;
+        }
+
+        step->duration_us = 0;
+        dur = strchr(tok, '@');
+        if (dur) {
+            *dur++ = '\0';
+            ret = kstrtou32(dur, 0, &step->duration_us);
+            if (ret)
+                return ret;
+            if (step->duration_us < TICK_PERIOD_MIN_US ||
+                step->duration_us > TICK_PERIOD_MAX_US)
+                return -EINVAL;
+        }
+
+        if (step->op == LED_OP_ROTATE) {
+            ret = kstrtos16(tok + 1, 0, &step->shift);
+            if (ret)
+                return ret;
+            if (*tok == '<')
+                step->shift = -step->shift;
+            bitmap_zero(step->mask, num_leds);
+        } else {
+            ret = bitmap_parse(tok, strlen(tok), step->mask, num_leds);
+            if (ret)
+                return ret;
+        }
+        pat->len++;
+    }
+
+    return pat->len ? 0 : -EINVAL;
+}
+
+// 점등 비트: 패턴과 현재 PWM 위상의 AND
+// 페이드를 쓰면 level 이 패턴 상태까지 반영하므로 (꺼진 LED 는 0 으로 수렴) PWM 위상만 사용
+static void led_output_bits(struct led_panel *panel, unsigned long *dst) {
+    if (panel->fade.duration_us)
+        bitmap_copy(dst, panel->pwm.phase, panel->num_leds);
+    else
+        bitmap_and(dst, panel->state.leds, panel->pwm.phase, panel->num_leds);
+}
+
+// led_commit/reset_leds/pwm_rebuild 는 panel->lock 쓰기 구간 안에서 호출
+// 뒤 버퍼에 출력 비트를 완성한 뒤 가운데 버퍼와 교환만 함
+// 백엔드 출력은 락을 푼 뒤 led_flush 가 담당하므로 임계 구역에 GPIO 쓰기가 없음
+static void led_commit(struct led_panel *panel) {
+    struct led_frame *back = panel->frame_back;
+
+    led_assert_locked(panel);
+
+    // 패턴 상태가 바뀌었으면 지금 밝기에서 새 목표로 페이드 시작 (출력은 다음 프레임부터)
+    if (panel->fade.duration_us &&
+        !bitmap_equal(panel->state.leds, panel->fade.target, panel->num_leds))
+        led_fade_start(panel);
+    led_output_bits(panel, back->bits);
+    back = (struct led_frame *)(xchg(&panel->frame_mid, (unsigned long)back | LED_FRAME_DIRTY)
+                                & ~LED_FRAME_DIRTY);
+    panel->frame_back = back;
+}
+
+// 새 프레임이 있으면 백엔드로 출력 (panel->lock 밖, sleep 불가 컨텍스트 포함)
+// 출력은 한 번에 한 곳에서만: 이미 출력 중이면 그쪽이 끝나기 전에 다시 확인하고 가져감
+static void led_flush(struct led_panel *panel) {
+    struct led_frame *front;
+
+    preempt_disable();
+    while (READ_ONCE(panel->frame_mid) & LED_FRAME_DIRTY) {
+        if (test_and_set_bit_lock(0, &panel->frame_busy))
+            break;
+        while (READ_ONCE(panel->frame_mid) & LED_FRAME_DIRTY) {
+            front = (struct led_frame *)(xchg(&panel->frame_mid, (unsigned long)panel->frame_front)
+                                         & ~LED_FRAME_DIRTY);
+            panel->frame_front = front;
+            if (trace_led_commit_enabled()) {
+                u64 t0 = ktime_get_ns();
+
+                panel->out->commit(panel, front->bits);
+                trace_led_commit(panel->id, panel->out->name, panel->num_leds,
+                                 ktime_get_ns() - t0);
+            } else {
+                panel->out->commit(panel, front->bits);
+            }
+        }
+        clear_bit_unlock(0, &panel->frame_busy);
+        // led_commit 의 xchg 와 짝: 해제 뒤 들어온 프레임을 놓치지 않도록
+        smp_mb__after_atomic();
+    }
+    preempt_enable();
+}
+
+// GPIO 백엔드: 전체 LED 패턴을 한 번의 배열 쓰기로 출력 (같은 칩의 핀은 레지스터 한 번)
+static void led_gpio_commit(struct led_panel *panel, const unsigned long *out) {
+    struct led_hwpwm *hwpwm = &panel->hwpwm;
+    unsigned int n = panel->num_leds;
+    DECLARE_BITMAP(gpio_out, LED_MAX_LEDS);
+    int j;
+
+    // 한 번에 확보한 배열은 array info 로 칩별 비트맵을 바로 쓰는 빠른 경로
+    if (panel->led_array) {
+        gpiod_set_array_value(n, panel->led_array->desc, panel->led_array->info,
+                              (unsigned long *)out);
+        return;
+    }
+    if (bitmap_empty(hwpwm->mask, n)) {
+        gpiod_set_array_value(n, panel->led_descs, NULL, (unsigned long *)out);
+        return;
+    }
+
+    // 하드웨어 PWM LED 는 점등 상태가 바뀔 때만 워크로 넘김
+    bitmap_and(gpio_out, out, hwpwm->mask, n);
+    if (!bitmap_equal(gpio_out, hwpwm->last, n)) {
+        bitmap_copy(hwpwm->last, gpio_out, n);
+        schedule_work(&hwpwm->work);
+    }
+
+    for (j = 0; j < panel->num_gpio_leds; j++)
+        __assign_bit(j, gpio_out, test_bit(panel->gpio_led_map[j], out));
+    if (panel->num_gpio_leds)
+        gpiod_set_array_value(panel->num_gpio_leds, panel->led_descs, NULL, gpio_out);
+}
+
+// 하드웨어 PWM 채널에 현재 점등 상태와 밝기를 적용 (프로세스 컨텍스트)
+static void hwpwm_work_fn(struct work_struct *work) {
+    struct led_panel *panel = container_of(work, struct led_panel, hwpwm.work);
+    struct led_hwpwm *hwpwm = &panel->hwpwm;
+    DECLARE_BITMAP(on, LED_MAX_LEDS);
+    unsigned int seq;
     int i;
-    for (i = 0; i < NUM_LEDS; i++) {
-        gpio_set_value(led_pins[i], 0);
-        led_states[i] = false;
+
+    do {
+        seq = read_seqbegin(&panel->lock);
+        led_output_bits(panel, on);
+        bitmap_and(on, on, hwpwm->mask, panel->num_leds);
+    } while (read_seqretry(&panel->lock, seq));
+
+    // 마스크는 probe 이후 바뀌지 않고, 듀티는 바이트 단위라 찢어진 값을 읽지 않음
+    for_each_set_bit(i, hwpwm->mask, panel->num_leds) {
+        struct pwm_device *p = hwpwm->chan[i].pwm;
+        struct pwm_state ps;
+
+        pwm_init_state(p, &ps);
+        if (!ps.period)
+            ps.period = PWM_PERIOD_NS;
+        pwm_set_relative_duty_cycle(&ps, test_bit(i, on) ? READ_ONCE(panel->level[i]) : 0,
+                                    LED_BRIGHTNESS_MAX);
+        ps.enabled = ps.duty_cycle != 0;
+        pwm_apply_state(p, &ps);
+    }
+}
+
+// LED 하나를 확보: pwm-names 에 "ledN" 이 있으면 하드웨어 PWM, 아니면 leds-gpios 의 N 번째
+static int led_pin_setup(struct led_panel *panel, int i) {
+    struct device *dev = panel->dev;
+    struct led_hwpwm_chan *chan = &panel->hwpwm.chan[i];
+    struct pwm_device *p;
+    struct gpio_desc *desc;
+
+    // pwm-names 에 없는 LED 는 조회 자체를 건너뜀 (LED 가 수백 개일 수 있음)
+    snprintf(chan->name, sizeof(chan->name), "led%d", i);
+    if (device_property_match_string(dev, "pwm-names", chan->name) >= 0) {
+        p = devm_pwm_get(dev, chan->name);
+        if (!IS_ERR(p)) {
+            chan->pwm = p;
+            set_bit(i, panel->hwpwm.mask);
+            dev_info(dev, "LED %d driven by hardware PWM\n", i);
+            return 0;
+        }
+        if (PTR_ERR(p) == -EPROBE_DEFER)
+            return -EPROBE_DEFER;
+    }
+
+    desc = devm_gpiod_get_index(dev, "leds", i, GPIOD_OUT_LOW);
+    if (IS_ERR(desc))
+        return dev_err_probe(dev, PTR_ERR(desc), "Failed to request LED GPIO %d\n", i);
+    panel->gpio_led_map[panel->num_gpio_leds] = i;
+    panel->led_descs[panel->num_gpio_leds++] = desc;
+    return 0;
+}
+
+static int led_gpio_count(struct device *dev) {
+    return gpiod_count(dev, "leds");
+}
+
+static int led_gpio_setup(struct led_panel *panel) {
+    struct device *dev = panel->dev;
+    struct gpio_descs *leds;
+    int ret, i;
+
+    panel->led_descs = kcalloc(panel->num_leds, sizeof(*panel->led_descs), GFP_KERNEL);
+    panel->gpio_led_map = kcalloc(panel->num_leds, sizeof(*panel->gpio_led_map), GFP_KERNEL);
+    panel->hwpwm.chan = kcalloc(panel->num_leds, sizeof(*panel->hwpwm.chan), GFP_KERNEL);
+    if (!panel->led_descs || !panel->gpio_led_map || !panel->hwpwm.chan)
+        return -ENOMEM;
+
+    // 하드웨어 PWM 을 쓰지 않으면 leds-gpios 전체를 요청 한 번으로 확보
+    // 핀과 PWM 채널은 모두 devm 이라 실패 경로와 remove 뒤에 한꺼번에 해제됨
+    if (!device_property_present(dev, "pwm-names")) {
+        leds = devm_gpiod_get_array(dev, "leds", GPIOD_OUT_LOW);
+        if (IS_ERR(leds))
+            return dev_err_probe(dev, PTR_ERR(leds), "Failed to request LED GPIOs\n");
+        panel->led_array = leds;
+        return 0;
+    }
+
+    for (i = 0; i < panel->num_leds; i++) {
+        ret = led_pin_setup(panel, i);
+        if (ret)
+            return ret;
+    }
+    return 0;
+}
+
+static void led_gpio_release(struct led_panel *panel) {
+    int i;
+
+    cancel_work_sync(&panel->hwpwm.work);
+    // 핀과 채널 반납은 devm 이 하고 여기서는 하드웨어 PWM 출력만 끔
+    for_each_set_bit(i, panel->hwpwm.mask, panel->num_leds)
+        pwm_disable(panel->hwpwm.chan[i].pwm);
+}
+
+static const struct led_output_ops led_gpio_ops = {
+    .name = "gpio",
+    .count = led_gpio_count,
+    .setup = led_gpio_setup,
+    .release = led_gpio_release,
+    .commit = led_gpio_commit,
+};
+
+// SPI 백엔드: 틱 경로는 준비된 버퍼를 spi_async 로 넘기기만 하고 기다리지 않음
+// 전송 중에 다시 커밋되면 다른 버퍼에 써 두고 완료 콜백이 이어서 보냄 (중간 프레임은 덮어씀)
+static void led_spi_complete(void *context);
+
+static void led_spi_submit(struct led_spi_out *o) {
+    o->xfer.tx_buf = o->buf[o->active];
+    // spi_message_init 이 메시지 전체를 0 으로 지우므로 콜백은 그 뒤에 건다
+    spi_message_init_with_transfers(&o->msg, &o->xfer, 1);
+    o->msg.complete = led_spi_complete;
+    o->msg.context = o;
+    o->busy = !spi_async(o->spi, &o->msg);
+}
+
+static void led_spi_complete(void *context) {
+    struct led_spi_out *o = context;
+    unsigned long flags;
+
+    spin_lock_irqsave(&o->lock, flags);
+    o->busy = false;
+    if (o->pending) {
+        o->pending = false;
+        o->active = !o->active;
+        led_spi_submit(o);
+    }
+    if (!o->busy)
+        wake_up(&o->idle);
+    spin_unlock_irqrestore(&o->lock, flags);
+}
+
+static void led_spi_commit(struct led_panel *panel, const unsigned long *out) {
+    struct led_spi_out *o = &panel->spi;
+    unsigned long flags;
+
+    spin_lock_irqsave(&o->lock, flags);
+    o->encode(panel, out, o->buf[o->busy ? !o->active : o->active]);
+
+    if (o->busy)
+        o->pending = true;
+    else
+        led_spi_submit(o);
+    spin_unlock_irqrestore(&o->lock, flags);
+}
+
+// 전송 버퍼 len 바이트 두 개를 잡고 SPI 를 설정 (max_hz 가 0 이면 Device Tree 의 spi-max-frequency)
+static int led_spi_init(struct led_panel *panel, size_t len, u32 max_hz,
+                        void (*encode)(struct led_panel *, const unsigned long *, u8 *)) {
+    struct led_spi_out *o = &panel->spi;
+    int ret;
+
+    o->spi = to_spi_device(panel->dev);
+    o->spi->bits_per_word = 8;
+    if (max_hz)
+        o->spi->max_speed_hz = max_hz;
+    ret = spi_setup(o->spi);
+    if (ret)
+        return ret;
+
+    // 스택이나 vmalloc 이 아닌 kmalloc 버퍼여야 DMA 가능
+    // encode 가 쓰지 않는 앞뒤 구간 (리셋/시작/끝 프레임) 은 0 으로 남음
+    o->len = len;
+    o->encode = encode;
+    o->buf[0] = kzalloc(o->len, GFP_KERNEL);
+    o->buf[1] = kzalloc(o->len, GFP_KERNEL);
+    if (!o->buf[0] || !o->buf[1])
+        return -ENOMEM;
+
+    o->xfer.len = o->len;
+    spin_lock_init(&o->lock);
+    init_waitqueue_head(&o->idle);
+    return 0;
+}
+
+// 타이머가 멈춘 뒤 호출: 마지막 (소등) 전송이 끝날 때까지 기다림
+static void led_spi_release(struct led_panel *panel) {
+    struct led_spi_out *o = &panel->spi;
+
+    wait_event(o->idle, !READ_ONCE(o->busy));
+}
+
+// 74HC595 체인: 래치(RCLK)는 칩 셀렉트에 연결
+// SPI 는 MSB 먼저 나가므로 LED 8r 은 레지스터 r 의 QA (비트 0)
+// 먼저 보낸 바이트가 체인 끝까지 밀려 가므로 마지막 레지스터부터 보냄
+static void led_595_encode(struct led_panel *panel, const unsigned long *out, u8 *buf) {
+    size_t len = panel->spi.len;
+    int r;
+
+    for (r = 0; r < len; r++)
+        buf[len - 1 - r] = bitmap_get_value8(out, r * 8);
+}
+
+// 레지스터 수는 gpio-74x164 바인딩과 같은 "registers-number" 속성
+static int led_595_count(struct device *dev) {
+    u32 regs;
+
+    if (device_property_read_u32(dev, "registers-number", &regs))
+        return -EINVAL;
+    return regs > LED_MAX_LEDS / 8 ? -EINVAL : regs * 8;
+}
+
+static int led_595_setup(struct led_panel *panel) {
+    return led_spi_init(panel, panel->num_leds / 8, 0, led_595_encode);
+}
+
+static const struct led_output_ops led_595_ops = {
+    .name = "74hc595",
+    .count = led_595_count,
+    .setup = led_595_setup,
+    .release = led_spi_release,
+    .commit = led_spi_commit,
+};
+
+// 주소 지정형 RGB 스트립 (WS2812, APA102): 프레임 비트맵은 점등 여부, 색과 밝기는 LED 별 배열
+// 밝기는 스트립이 직접 처리하므로 소프트웨어 PWM 을 쓰지 않음
+// 밝기 배율은 (x * (b + 1)) >> 8: b = 255 이면 그대로, b = 0 이면 0
+static inline u32 led_rgb_value(struct led_panel *panel, const unsigned long *out, int i) {
+    u32 c = READ_ONCE(panel->color[i]);
+    u32 b = READ_ONCE(panel->level[i]) + 1;
+
+    if (!test_bit(i, out))
+        return 0;
+    if (b == LED_BRIGHTNESS_MAX + 1)
+        return c;
+    return (((c >> 16 & 0xff) * b >> 8) << 16) | (((c >> 8 & 0xff) * b >> 8) << 8) |
+           ((c & 0xff) * b >> 8);
+}
+
+// 색 한 바이트의 WS2812 비트열 (SPI 3바이트): module init 에서 한 번 계산
+static u8 ws2812_lut[256][3] __read_mostly;
+
+// 데이터 비트 0 은 100, 1 은 110 (2.4MHz 에서 high 0.42us / 0.83us)
+static void __init ws2812_lut_init(void) {
+    u32 bits;
+    int v, b;
+
+    for (v = 0; v < 256; v++) {
+        bits = 0;
+        for (b = 7; b >= 0; b--)
+            bits = bits << 3 | ((v & BIT(b)) ? 0x6 : 0x4);
+        ws2812_lut[v][0] = bits >> 16;
+        ws2812_lut[v][1] = bits >> 8;
+        ws2812_lut[v][2] = bits;
+    }
+}
+
+// WS2812 는 G, R, B 순서로 LED 0 부터, 끝의 0 구간이 리셋(래치)
+static void led_ws2812_encode(struct led_panel *panel, const unsigned long *out, u8 *buf) {
+    u32 c;
+    int i;
+
+    for (i = 0; i < panel->num_leds; i++, buf += WS2812_BYTES_PER_LED) {
+        c = led_rgb_value(panel, out, i);
+        memcpy(buf, ws2812_lut[c >> 8 & 0xff], 3);
+        memcpy(buf + 3, ws2812_lut[c >> 16 & 0xff], 3);
+        memcpy(buf + 6, ws2812_lut[c & 0xff], 3);
+    }
+}
+
+// APA102: 32비트 0 시작 프레임, LED 마다 (0xe0 | 전역 밝기 5비트), B, G, R
+// 끝 프레임은 LED 두 개당 클럭 하나 이상 (0 으로 남겨 둔 뒤쪽 바이트)
+static void led_apa102_encode(struct led_panel *panel, const unsigned long *out, u8 *buf) {
+    u32 c;
+    int i;
+
+    for (i = 0, buf += 4; i < panel->num_leds; i++, buf += 4) {
+        c = led_rgb_value(panel, out, i);
+        buf[0] = 0xff;
+        buf[1] = c;
+        buf[2] = c >> 8;
+        buf[3] = c >> 16;
+    }
+}
+
+// 스트립 길이는 "led-count" 속성
+static int led_strip_count(struct device *dev) {
+    u32 n;
+
+    if (device_property_read_u32(dev, "led-count", &n))
+        return -EINVAL;
+    return n > LED_MAX_LEDS ? -EINVAL : n;
+}
+
+static int led_strip_colors_init(struct led_panel *panel) {
+    int i;
+
+    panel->color = kcalloc(panel->num_leds, sizeof(*panel->color), GFP_KERNEL);
+    if (!panel->color)
+        return -ENOMEM;
+    for (i = 0; i < panel->num_leds; i++)
+        panel->color[i] = LED_COLOR_WHITE;
+    return 0;
+}
+
+static int led_ws2812_setup(struct led_panel *panel) {
+    int ret = led_strip_colors_init(panel);
+
+    if (ret)
+        return ret;
+    // 비트 타이밍이 클럭에 달려 있으므로 Device Tree 값 대신 고정 클럭
+    return led_spi_init(panel, panel->num_leds * WS2812_BYTES_PER_LED + WS2812_RESET_BYTES,
+                        WS2812_SPI_HZ, led_ws2812_encode);
+}
+
+static int led_apa102_setup(struct led_panel *panel) {
+    int ret = led_strip_colors_init(panel);
+
+    if (ret)
+        return ret;
+    return led_spi_init(panel, 4 + panel->num_leds * 4 + DIV_ROUND_UP(panel->num_leds, 16),
+                        0, led_apa102_encode);
+}
+
+static const struct led_output_ops led_ws2812_ops = {
+    .name = "ws2812",
+    .rgb = true,
+    .count = led_strip_count,
+    .setup = led_ws2812_setup,
+    .release = led_spi_release,
+    .commit = led_spi_commit,
+};
+
+static const struct led_output_ops led_apa102_ops = {
+    .name = "apa102",
+    .rgb = true,
+    .count = led_strip_count,
+    .setup = led_apa102_setup,
+    .release = led_spi_release,
+    .commit = led_spi_commit,
+};
+
+static void reset_leds(struct led_panel *panel) {
+    bitmap_zero(panel->state.leds, panel->num_leds);
+    led_commit(panel);
+}
+
+// 추적은 LED 수나 머리 수와 무관하게 두 단계: 머리들을 켠 뒤 한 칸씩 회전 반복
+// 머리는 논리 순서에서 같은 간격, direction 0 은 마지막 위치부터 아래로, 1 은 첫 위치부터 위로
+// probe 또는 panel->lock 쓰기 구간 안에서 호출
+static void led_chase_init(struct led_panel *panel) {
+    unsigned int n = panel->num_leds, h = panel->chase_heads, k;
+    struct led_pattern *down = &panel->patterns[LED_PAT_CHASE_DOWN];
+    struct led_pattern *up = &panel->patterns[LED_PAT_CHASE_UP];
+
+    memset(down, 0, sizeof(*down));
+    memset(up, 0, sizeof(*up));
+    for (k = 0; k < h; k++) {
+        set_bit(n - 1 - k * n / h, down->steps[0].mask);
+        set_bit(k * n / h, up->steps[0].mask);
+    }
+
+    down->len = 2;
+    down->loop = 1;
+    down->ordered = panel->ordered;
+    down->steps[1].op = LED_OP_ROTATE;
+    down->steps[1].shift = -1;
+
+    up->len = 2;
+    up->loop = 1;
+    up->ordered = panel->ordered;
+    up->steps[1].op = LED_OP_ROTATE;
+    up->steps[1].shift = 1;
+}
+
+// 기본 모드들도 모두 패턴 테이블로 미리 만들어 둔다
+static void led_patterns_init(struct led_panel *panel) {
+    struct led_pattern *patterns = panel->patterns;
+    unsigned int n = panel->num_leds;
+    struct led_pattern *pat;
+
+    pat = &patterns[LED_PAT_BLINK];
+    pat->len = 2;
+    bitmap_fill(pat->steps[0].mask, n);
+    bitmap_zero(pat->steps[1].mask, n);
+
+    led_chase_init(panel);
+
+    pat = &patterns[LED_PAT_MANUAL];
+    pat->len = 1;
+    pat->loop = 1;
+    pat->steps[0].op = LED_OP_XOR;
+    bitmap_fill(pat->steps[0].mask, n);
+}
+
+// nbits 비트 안에서 위쪽(높은 번호 LED)으로 shift 칸 회전, dst == src 가능
+static void led_bitmap_rotate(unsigned long *dst, const unsigned long *src, int shift,
+                              unsigned int nbits) {
+    DECLARE_BITMAP(wrap, LED_MAX_LEDS);
+    unsigned int k = ((shift % (int)nbits) + nbits) % nbits;
+
+    if (!k) {
+        bitmap_copy(dst, src, nbits);
+        return;
+    }
+    bitmap_shift_right(wrap, src, nbits - k, nbits);
+    bitmap_shift_left(dst, src, k, nbits);
+    bitmap_or(dst, dst, wrap, nbits);
+}
+
+// 고정 CPU 를 써야 하는데 다른 CPU 라면 그 CPU 의 워크로 넘김 (선점 불가 구간에서 호출)
+static bool led_cpu_elsewhere(int cpu) {
+    return cpu >= 0 && cpu != smp_processor_id() && cpu_online(cpu);
+}
+
+// 다음 격자 경계: 여러 패널이 같은 시각 축에 맞춰 깨어남
+static ktime_t led_sync_next_boundary(void) {
+    u64 period = ktime_to_ns(us_to_ktime(READ_ONCE(tick_period_us)));
+
+    return ns_to_ktime((div64_u64(ktime_get(), period) + 1) * period);
+}
+
+// 공유 타이머 시작 (led_sync_lock 안에서 호출), _PINNED 라 시작한 CPU 에 머묾
+static void led_sync_arm(void) {
+    if (hrtimer_is_queued(&led_sync_timer))
+        return;
+    if (led_cpu_elsewhere(READ_ONCE(led_cpu)))
+        queue_work_on(READ_ONCE(led_cpu), system_highpri_wq, &led_sync_kick_work);
+    else
+        hrtimer_start(&led_sync_timer, led_sync_next_boundary(), HRTIMER_MODE_ABS_PINNED);
+}
+
+static void led_sync_kick_fn(struct work_struct *work) {
+    spin_lock_irq(&led_sync_lock);
+    if (led_sync_users && !hrtimer_is_queued(&led_sync_timer))
+        hrtimer_start(&led_sync_timer, led_sync_next_boundary(), HRTIMER_MODE_ABS_PINNED);
+    spin_unlock_irq(&led_sync_lock);
+}
+
+// 공유 타이머 등록/해제 (panel->lock 쓰기 구간 안에서 호출, 락 순서는 panel->lock -> led_sync_lock)
+static void led_sync_start(struct led_panel *panel) {
+    panel->sync_due = ktime_add(ktime_get(), led_tick_period(panel));
+
+    spin_lock(&led_sync_lock);
+    if (!panel->sync_running) {
+        panel->sync_running = true;
+        led_sync_users++;
+    }
+    led_sync_arm();
+    spin_unlock(&led_sync_lock);
+}
+
+static void led_sync_stop(struct led_panel *panel) {
+    spin_lock(&led_sync_lock);
+    if (panel->sync_running) {
+        panel->sync_running = false;
+        led_sync_users--;
+    }
+    spin_unlock(&led_sync_lock);
+}
+
+static ktime_t led_kick_delay(struct led_panel *panel, int bit) {
+    return bit == LED_KICK_TIMER ? led_tick_period(panel) : 0;
+}
+
+// 패널 타이머를 panel->cpu 에서 시작 (panel->lock 쓰기 구간 안에서 호출)
+// 이 CPU 가 아니면 대상 CPU 의 워크가 대신 시작하고, 이후 재설정은 _PINNED 라 그 CPU 에 머묾
+static void led_hrtimer_start(struct led_panel *panel, int bit) {
+    struct hrtimer *timer = bit == LED_KICK_TIMER ? &panel->led_timer : &panel->pwm_timer;
+    int cpu = READ_ONCE(panel->cpu);
+
+    led_assert_locked(panel);
+
+    // suspend 중에는 PWM 을 다시 돌리지 않음: resume 의 pwm_apply 가 시작
+    if (bit == LED_KICK_PWM && panel->pm_parked)
+        return;
+
+    if (led_cpu_elsewhere(cpu)) {
+        set_bit(bit, &panel->kick);
+        queue_work_on(cpu, system_highpri_wq, &panel->kick_work);
+        return;
+    }
+    clear_bit(bit, &panel->kick);
+    hrtimer_start(timer, led_kick_delay(panel, bit), HRTIMER_MODE_REL_PINNED);
+}
+
+static void led_kick_fn(struct work_struct *work) {
+    struct led_panel *panel = container_of(work, struct led_panel, kick_work);
+
+    write_seqlock_irq(&panel->lock);
+    if (test_and_clear_bit(LED_KICK_TIMER, &panel->kick))
+        hrtimer_start(&panel->led_timer, led_kick_delay(panel, LED_KICK_TIMER),
+                      HRTIMER_MODE_REL_PINNED);
+    if (test_and_clear_bit(LED_KICK_PWM, &panel->kick))
+        hrtimer_start(&panel->pwm_timer, 0, HRTIMER_MODE_REL_PINNED);
+    write_sequnlock_irq(&panel->lock);
+}
+
+// 패널 타이머 시작/정지 (panel->lock 쓰기 구간 안에서 호출)
+// 독립 타이머는 콜백이 실행 중이면 패턴이 없는 것을 보고 스스로 멈춤
+static void led_timer_start(struct led_panel *panel) {
+    if (sync_tick)
+        led_sync_start(panel);
+    else
+        led_hrtimer_start(panel, LED_KICK_TIMER);
+}
+
+static void led_timer_stop(struct led_panel *panel) {
+    if (sync_tick) {
+        led_sync_stop(panel);
+        return;
+    }
+    clear_bit(LED_KICK_TIMER, &panel->kick);
+    hrtimer_try_to_cancel(&panel->led_timer);
+}
+
+// 패턴을 처음 단계부터 재생 (panel->lock 쓰기 구간 안에서 호출)
+// 모드 4 (스트림) 는 pattern 없이 링의 프레임을 출력
+static void led_select_pattern(struct led_panel *panel, int mode, const struct led_pattern *pat) {
+    led_assert_locked(panel);
+
+    panel->state.mode = mode;
+    panel->state.pattern = pat;
+    panel->state.step = 0;
+    panel->state.still = 0;
+    led_timer_start(panel);
+}
+
+// 시각이 된 프레임 중 가장 최근 것만 출력하고 그 앞은 건너뜀
+// (panel->lock 쓰기 구간 안에서 호출)
+static void led_stream_step(struct led_panel *panel) {
+    struct ledctl_ring *ring = panel->stream_ring;
+    const struct ledctl_frame *frame = NULL;
+    u32 head = smp_load_acquire(&ring->head);
+    u32 tail = panel->stream_tail;
+    u64 now = ktime_get_ns();
+
+    led_assert_locked(panel);
+
+    // 사용자 공간이 링 크기보다 앞서 쓴 경우는 잘못된 head 로 보고 무시
+    if (head - tail > LEDCTL_RING_FRAMES)
+        return;
+
+    while (tail != head) {
+        const struct ledctl_frame *next = &ring->frames[tail & (LEDCTL_RING_FRAMES - 1)];
+
+        if (READ_ONCE(next->timestamp_ns) > now)
+            break;
+        frame = next;
+        tail++;
+    }
+    if (!frame)
+        return;
+
+    bitmap_from_arr32(panel->state.leds, frame->leds, panel->num_leds);
+    led_commit(panel);
+
+    // 프레임을 다 읽은 뒤에 tail 을 공개해야 사용자 공간이 덮어쓰지 않음
+    panel->stream_tail = tail;
+    smp_store_release(&ring->tail, tail);
+}
+
+// panel->level 로부터 듀티 순 엣지 목록을 다시 만든다
+// 0 과 최대 밝기는 주기 중 바뀌지 않으므로 엣지가 필요 없음
+// 페이드 중에는 hardirq 에서 프레임마다 불리므로 정렬 대신 듀티별 버킷으로 O(N)
+static void pwm_rebuild(struct led_panel *panel) {
+    struct led_pwm *pwm = &panel->pwm;
+    DECLARE_BITMAP(used, LED_BRIGHTNESS_MAX + 1);
+    unsigned int duty;
+    int i, m = 0;
+
+    bitmap_zero(pwm->on_mask, panel->num_leds);
+    bitmap_zero(used, LED_BRIGHTNESS_MAX + 1);
+    for (i = 0; i < panel->num_leds; i++) {
+        duty = panel->level[i];
+        if (duty)
+            __set_bit(i, pwm->on_mask);
+        // 하드웨어 PWM LED 와 RGB 스트립은 주변장치가 듀티를 처리
+        if (duty == 0 || duty == LED_BRIGHTNESS_MAX || panel->out->rgb ||
+            test_bit(i, panel->hwpwm.mask))
+            continue;
+        __set_bit(duty, used);
+    }
+
+    // 같은 듀티끼리 한 엣지: 주기당 깨어나는 횟수 = 서로 다른 듀티 수
+    for_each_set_bit(duty, used, LED_BRIGHTNESS_MAX + 1) {
+        pwm->slot[duty] = m;
+        pwm->edges[m].duty = duty;
+        pwm->edges[m].offset_ns = (u32)div_u64((u64)duty * PWM_PERIOD_NS,
+                                               LED_BRIGHTNESS_MAX);
+        bitmap_zero(pwm->edges[m].off, panel->num_leds);
+        m++;
+    }
+
+    for (i = 0; i < panel->num_leds; i++) {
+        duty = panel->level[i];
+        if (test_bit(duty, used) && !test_bit(i, panel->hwpwm.mask))
+            __set_bit(i, pwm->edges[pwm->slot[duty]].off);
+    }
+
+    pwm->num_edges = m;
+    pwm->next_edge = m;
+    bitmap_copy(pwm->phase, pwm->on_mask, panel->num_leds);
+}
+
+// 밝기 변경을 반영: 페이드를 쓰면 새 밝기로 다시 보간, 아니면 바로 엣지 목록 갱신
+// PWM 타이머를 시작/정지 (panel->lock 쓰기 구간 안에서 호출)
+static void pwm_apply(struct led_panel *panel) {
+    led_assert_locked(panel);
+
+    if (panel->fade.duration_us)
+        led_fade_start(panel);
+    else
+        memcpy(panel->level, panel->brightness, panel->num_leds);
+    pwm_rebuild(panel);
+    if (panel->pwm.num_edges || panel->fade.active) {
+        led_hrtimer_start(panel, LED_KICK_PWM);
+    } else {
+        clear_bit(LED_KICK_PWM, &panel->kick);
+        hrtimer_try_to_cancel(&panel->pwm_timer);
+    }
+    if (!bitmap_empty(panel->hwpwm.mask, panel->num_leds))
+        schedule_work(&panel->hwpwm.work);  // 밝기 변경 반영
+    led_commit(panel);
+}
+
+// 지각 밝기 -> 듀티 (감마 2.0 근사) 와 그 역: module init 에서 한 번 계산
+static u8 led_gamma[256] __read_mostly;
+static u8 led_gamma_inv[256] __read_mostly;
+
+static void __init led_gamma_init(void) {
+    int v;
+
+    for (v = 0; v < 256; v++) {
+        led_gamma[v] = DIV_ROUND_CLOSEST(v * v, LED_BRIGHTNESS_MAX);
+        led_gamma_inv[v] = int_sqrt(v * LED_BRIGHTNESS_MAX);
+    }
+}
+
+// 현재 출력 듀티에서 state.leds 와 brightness 가 정하는 목표로 페이드를 다시 시작
+// (panel->lock 쓰기 구간 안에서 호출, 첫 프레임은 곧바로 시작하는 PWM 주기에서)
+static void led_fade_start(struct led_panel *panel) {
+    struct led_fade *fade = &panel->fade;
+    int i;
+
+    led_assert_locked(panel);
+
+    bitmap_copy(fade->target, panel->state.leds, panel->num_leds);
+    for (i = 0; i < panel->num_leds; i++) {
+        fade->from[i] = led_gamma_inv[panel->level[i]];
+        fade->to[i] = test_bit(i, fade->target) ? led_gamma_inv[panel->brightness[i]] : 0;
+    }
+    fade->start = ktime_get();
+    fade->active = true;
+    // 이미 걸려 있으면 다음 주기 시작에서 첫 프레임 (PWM 주기를 끊지 않음)
+    if (!hrtimer_is_queued(&panel->pwm_timer))
+        led_hrtimer_start(panel, LED_KICK_PWM);
+}
+
+// 페이드 한 프레임 (PWM 주기 시작, panel->lock 쓰기 구간 안에서 호출)
+// 본 루프는 LED 마다 분기 없이 u8 배열에서 곱셈 두 번과 표 조회 하나라 컴파일러가 벡터화 가능
+// 마지막 프레임은 반올림 오차 없이 목표 밝기를 그대로 넣고 페이드 종료
+static void led_fade_frame(struct led_panel *panel, ktime_t now) {
+    struct led_fade *fade = &panel->fade;
+    const u8 *from = fade->from, *to = fade->to;
+    u8 *level = panel->level;
+    int i, n = panel->num_leds;
+    u64 elapsed = ktime_to_ns(ktime_sub(now, fade->start));
+    u32 t;
+
+    t = min_t(u64, div64_u64(elapsed * FADE_ONE, (u64)fade->duration_us * NSEC_PER_USEC),
+              FADE_ONE);
+    if (t == FADE_ONE) {
+        for (i = 0; i < n; i++)
+            level[i] = test_bit(i, fade->target) ? panel->brightness[i] : 0;
+        fade->active = false;
+        return;
+    }
+
+    for (i = 0; i < n; i++)
+        level[i] = led_gamma[(from[i] * (FADE_ONE - t) + to[i] * t) >> 8];
+}
+
+// 하나의 hrtimer 가 주기 시작과 각 엣지 묶음마다 한 번씩 깨어남
+// 페이드 중에는 주기 시작마다 프레임을 계산하고 엣지 목록을 새로 만듦 (엣지가 없어도 계속 돎)
+static enum hrtimer_restart pwm_timer_callback(struct hrtimer *timer) {
+    struct led_panel *panel = container_of(timer, struct led_panel, pwm_timer);
+    struct led_pwm *pwm = &panel->pwm;
+    enum hrtimer_restart ret = HRTIMER_RESTART;
+    u32 next;
+
+    trace_led_pwm_tick(panel->id, hrtimer_get_expires(timer), hrtimer_cb_get_time(timer));
+    led_stat_inc(panel, pwm_ticks);
+
+    write_seqlock(&panel->lock);
+
+    // 그 사이 pwm_apply 가 타이머를 다시 시작했다면 그 설정을 유지
+    if (hrtimer_is_queued(timer))
+        goto out;
+
+    if (!pwm->num_edges && !panel->fade.active) {
+        ret = HRTIMER_NORESTART;
+        goto out;
+    }
+
+    if (pwm->next_edge >= pwm->num_edges) {
+        if (panel->fade.active) {
+            led_fade_frame(panel, hrtimer_cb_get_time(timer));
+            pwm_rebuild(panel);
+            if (!bitmap_empty(panel->hwpwm.mask, panel->num_leds))
+                schedule_work(&panel->hwpwm.work);
+        }
+        // 주기 시작: 밝기가 0 이 아닌 LED 모두 켜기
+        pwm->period_start = hrtimer_get_expires(timer);
+        // 한 주기 이상 밀렸으면 위상을 현재 시각으로 다시 맞춤
+        if (ktime_after(hrtimer_cb_get_time(timer),
+                        ktime_add_ns(pwm->period_start, PWM_PERIOD_NS)))
+            pwm->period_start = hrtimer_cb_get_time(timer);
+        bitmap_copy(pwm->phase, pwm->on_mask, panel->num_leds);
+        pwm->next_edge = 0;
+    } else {
+        // 같은 듀티의 LED 묶음을 한 번에 끄기
+        bitmap_andnot(pwm->phase, pwm->phase, pwm->edges[pwm->next_edge].off,
+                      panel->num_leds);
+        pwm->next_edge++;
+    }
+    led_commit(panel);
+    // 커밋이 페이드를 시작하며 타이머를 다시 걸었다면 그 설정을 유지
+    if (hrtimer_is_queued(timer))
+        goto out;
+
+    next = (pwm->next_edge < pwm->num_edges)
+        ? pwm->edges[pwm->next_edge].offset_ns
+        : PWM_PERIOD_NS;
+    hrtimer_set_expires(timer, ktime_add_ns(pwm->period_start, next));
+
+out:
+    write_sequnlock(&panel->lock);
+    led_flush(panel);
+
+    return ret;
+}
+
+// 누름 하나에 깨움 이벤트 하나: 보고하면 비트를 세우고 떼어짐이 확인되어야 내림
+static void led_switch_report_wake(struct led_switch *sw) {
+    if (device_may_wakeup(sw->panel->dev) && !test_and_set_bit(LED_SW_WAKE_REPORTED, &sw->wake))
+        pm_wakeup_event(sw->panel->dev, LED_WAKE_MS);
+}
+
+// 하드 IRQ 상단부: 엣지 시각만 기록하고 모드 전환은 스레드 핸들러로 넘긴다
+static irqreturn_t switch_handler(int irq, void *dev_id) {
+    struct led_switch *sw = dev_id;
+    irqreturn_t ret = IRQ_WAKE_THREAD;
+    u64 t0 = led_stat_clock();
+
+    trace_led_switch_irq_entry(sw->panel->id, sw->id);
+    led_stat_inc(sw->panel, irqs[sw->id]);
+    sw->last_time = ktime_get();
+
+    // 하드웨어 디바운스는 엣지 하나가 누름 하나 (소프트웨어 디바운스는 콜백이 보고)
+    if (sw->hw_debounce)
+        led_switch_report_wake(sw);
+
+    if (!sw->hw_debounce) {
+        // 디바운스 구간 동안 IRQ 를 꺼 둠: 그 사이 엣지는 래치만 되고 콜백이 떼어짐을 확인한 뒤 켬
+        disable_irq_nosync(irq);
+        hrtimer_start(&sw->debounce_timer,
+                      us_to_ktime(READ_ONCE(sw->panel->debounce_us)), HRTIMER_MODE_REL_PINNED);
+        ret = IRQ_HANDLED;
+    }
+
+    led_stat_hist_since(sw->panel, irq_hist, t0);
+    trace_led_switch_irq_exit(sw->panel->id, sw->id);
+    return ret;
+}
+
+// 디바운스 구간이 끝나면 레벨을 샘플해 떼어짐 -> 눌림 전환에서만 스레드를 한 번 깨움
+// 누르고 있는 동안은 IRQ 를 꺼 둔 채 떼어질 때까지 주기적으로 다시 샘플
+// (IRQ 를 켜면 꺼져 있던 동안 래치된 바운스 엣지가 재생되므로 떼어진 뒤에야 켬)
+// 재생된 엣지가 연 구간은 떼어진 레벨을 읽고 바운스로 버림
+static enum hrtimer_restart switch_debounce_callback(struct hrtimer *timer) {
+    struct led_switch *sw = container_of(timer, struct led_switch, debounce_timer);
+    bool injected = led_switch_injected(sw);  // 주입은 누름과 뗌을 한 번에 한 것으로 처리
+    bool pressed = gpiod_get_value(sw->desc) > 0;
+    bool was = sw->pressed;
+
+    sw->pressed = pressed;
+    if (injected || (pressed && !was)) {
+        led_switch_report_wake(sw);
+        irq_wake_thread(sw->irq, sw);
+    }
+
+    if (pressed) {
+        hrtimer_forward_now(timer, us_to_ktime(READ_ONCE(sw->panel->debounce_us)));
+        return HRTIMER_RESTART;
+    }
+
+    // 떼어짐 확인: 다음 누름은 다시 보고 (재생된 엣지는 하드 IRQ 에서 보고하지 않으므로 먼저 내려도 됨)
+    clear_bit(LED_SW_WAKE_REPORTED, &sw->wake);
+    enable_irq(sw->irq);
+    if (!was && !injected) {
+        led_stat_inc(sw->panel, debounce_drops[sw->id]);
+        trace_led_debounce_drop(sw->panel->id, sw->id);
+    }
+    return HRTIMER_NORESTART;
+}
+
+// 모든 클라이언트 큐에 이벤트 추가: 할당 없음, 큐가 가득 차면 버리고 개수만 셈
+static void ledctl_post_event(struct led_panel *panel, int switch_id, ktime_t when,
+                              ktime_t commit, int mode) {
+    struct ledctl_client *client;
+    struct ledctl_event ev = {
+        .timestamp_ns = ktime_to_ns(when),
+        .switch_id = switch_id,
+        .mode = mode,
+        .commit_ns = ktime_to_ns(commit),
+    };
+
+    rcu_read_lock();
+    list_for_each_entry_rcu(client, &panel->clients, node) {
+        spin_lock(&client->lock);
+        if (kfifo_is_full(&client->events)) {
+            client->dropped++;
+            spin_unlock(&client->lock);
+            continue;
+        }
+        ev.dropped = client->dropped;
+        client->dropped = 0;
+        kfifo_put(&client->events, ev);
+        spin_unlock(&client->lock);
+
+        wake_up_interruptible(&client->wait);
+    }
+    rcu_read_unlock();
+}
+
+// 스레드 하단부: 프로세스 컨텍스트, 타이머(hardirq)와 경합하므로 _irq 사용
+// 모드 0-3 으로 전환: 스위치와 LED_CMD_MODE 가 공유 (panel->lock 쓰기 구간 안에서 호출)
+// 출력 비트맵을 직접 바꿨으면 true 를 돌려주고 호출자가 led_commit
+static bool led_apply_mode(struct led_panel *panel, int mode) {
+    struct led_state *state = &panel->state;
+
+    switch (mode) {
+        case 0: // 전체 모드
+            led_select_pattern(panel, 0, &panel->patterns[LED_PAT_BLINK]);
+            break;
+
+        case 1: // 개별 모드
+            led_select_pattern(panel, 1, &panel->patterns[state->direction == 0
+                                                          ? LED_PAT_CHASE_DOWN
+                                                          : LED_PAT_CHASE_UP]);
+            break;
+
+        case 2: // 수동 모드: 누를 때마다 한 번 토글하고 정지
+            led_select_pattern(panel, 2, &panel->patterns[LED_PAT_MANUAL]);
+            break;
+
+        case 3: // 리셋 모드
+            bitmap_zero(state->leds, panel->num_leds);
+            state->mode = -1;
+            state->pattern = NULL;
+            led_timer_stop(panel);
+            return true;
+    }
+    return false;
+}
+
+// 모드 -1 이고 모든 LED 가 꺼져 있으면 유휴: 런타임 PM 참조를 놓아 autosuspend 허용
+// (panel->lock 쓰기 구간 안에서 호출, 두 방향 모두 sleep 하지 않음)
+// 유휴에서 벗어나는 쪽은 스위치 스레드와 cmd_work 뿐이고 둘 다 미리 pm_runtime_get_sync 로 깨움
+static void led_pm_update(struct led_panel *panel) {
+    bool idle = panel->state.mode < 0 && bitmap_empty(panel->state.leds, panel->num_leds);
+
+    if (idle != panel->pm_busy)
+        return;
+    panel->pm_busy = !idle;
+    if (idle) {
+        pm_runtime_mark_last_busy(panel->dev);
+        pm_runtime_put_autosuspend(panel->dev);
+    } else {
+        pm_runtime_get_noresume(panel->dev);
+    }
+}
+
+// 명령 하나 적용 (panel->lock 쓰기 구간 안에서 호출), 출력 비트맵을 바꿨으면 true
+static bool led_cmd_apply(struct led_panel *panel, const struct led_cmd *cmd) {
+    struct led_state *state = &panel->state;
+
+    switch (cmd->op) {
+        case LED_CMD_MODE:
+            return led_apply_mode(panel, cmd->arg);
+
+        case LED_CMD_DIRECTION:
+            state->direction = cmd->arg;
+            if (state->mode == 1)
+                led_apply_mode(panel, 1);
+            break;
+
+        case LED_CMD_PATTERN:
+            panel->patterns[LED_PAT_USER] = *cmd->pat;
+            led_select_pattern(panel, 3, &panel->patterns[LED_PAT_USER]);
+            break;
+
+        case LED_CMD_STREAM:
+            if (cmd->arg)
+                led_select_pattern(panel, LED_MODE_STREAM, NULL);
+            else if (state->mode == LED_MODE_STREAM) {
+                state->mode = -1;
+                led_timer_stop(panel);
+            }
+            break;
+    }
+    return false;
+}
+
+// 쌓인 명령을 모두 꺼내 순서대로 적용 (panel->lock 쓰기 구간 안에서 호출)
+// 꺼내는 쪽은 항상 lock 보유자 하나라 kfifo 의 단일 소비자 조건을 만족
+// 출력 비트맵을 바꾼 명령이 있으면 true: 호출자가 묶음 전체에 대해 led_commit 한 번
+static bool led_cmd_drain(struct led_panel *panel) {
+    struct led_cmd cmd;
+    bool dirty = false, any = false;
+
+    led_assert_locked(panel);
+
+    while (kfifo_get(&panel->cmds, &cmd)) {
+        if (!panel->dead) {
+            dirty |= led_cmd_apply(panel, &cmd);
+            any = true;
+        }
+        kfree(cmd.pat);
+    }
+    if (any)
+        led_pm_update(panel);
+    return dirty;
+}
+
+// 다음 틱이 LED_CMD_LATENCY_US 안에 오는지 (panel->lock 쓰기 구간 안에서 호출)
+static bool led_tick_soon(struct led_panel *panel) {
+    ktime_t limit = ktime_add_us(ktime_get(), LED_CMD_LATENCY_US);
+
+    if (sync_tick)
+        return panel->sync_running && ktime_before(panel->sync_due, limit);
+    return hrtimer_is_queued(&panel->led_timer) &&
+           ktime_before(hrtimer_get_expires(&panel->led_timer), limit);
+}
+
+// 틱이 멈춰 있거나 한참 뒤라면 틱 대신 명령을 적용
+static void led_cmd_work_fn(struct work_struct *work) {
+    struct led_panel *panel = container_of(work, struct led_panel, cmd_work);
+
+    // 유휴 패널을 깨우는 명령일 수 있으므로 PWM 을 먼저 되살림
+    pm_runtime_get_sync(panel->dev);
+    write_seqlock_irq(&panel->lock);
+    // 시스템 suspend 중에 들어온 명령은 resume 이 적용
+    if (!panel->suspended && !led_tick_soon(panel) && led_cmd_drain(panel))
+        led_commit(panel);
+    write_sequnlock_irq(&panel->lock);
+    led_flush(panel);
+    pm_runtime_mark_last_busy(panel->dev);
+    pm_runtime_put_autosuspend(panel->dev);
+}
+
+// 명령 하나를 링에 넣음: panel->lock 을 잡지 않으므로 틱과 다투지 않음
+// 링이 가득 차 있으면 기다리지 않고 -EAGAIN (성공하면 pat 은 소비자가 해제)
+static int led_cmd_post(struct led_panel *panel, u32 op, u32 arg, struct led_pattern *pat) {
+    struct led_cmd cmd = { .op = op, .arg = arg, .pat = pat };
+    bool queued;
+
+    if (READ_ONCE(panel->dead))
+        return -ENODEV;
+
+    spin_lock(&panel->cmd_lock);
+    queued = kfifo_put(&panel->cmds, cmd);
+    spin_unlock(&panel->cmd_lock);
+    if (!queued)
+        return -EAGAIN;
+
+    queue_work(system_highpri_wq, &panel->cmd_work);
+    return 0;
+}
+
+// IRQF_ONESHOT 이므로 이 함수가 끝날 때까지 해당 IRQ 라인은 마스크된 상태
+// 타이머 시작/취소도 panel->lock 안에서 해야 콜백의 hrtimer_forward 와 겹치지 않음
+static irqreturn_t switch_thread_handler(int irq, void *dev_id) {
+    struct led_switch *sw = dev_id;
+    struct led_panel *panel = sw->panel;
+    struct led_state *state = &panel->state;
+    int old_mode, mode;
+    u64 t0 = led_stat_clock();
+    ktime_t done;
+
+    trace_led_switch_thread_entry(panel->id, sw->id);
+    clear_bit(0, &sw->inject);
+
+    pm_runtime_get_sync(panel->dev);
+    write_seqlock_irq(&panel->lock);
+
+    // 깨움 스위치는 suspend 도중에도 IRQ 가 살아 있음: 패널을 다시 움직이지 않고 resume 으로 넘김
+    if (panel->suspended) {
+        set_bit(LED_SW_WAKE_PENDING, &sw->wake);
+        write_sequnlock_irq(&panel->lock);
+        pm_runtime_put_noidle(panel->dev);
+        goto out;
+    }
+
+    if (led_cmd_drain(panel))
+        led_commit(panel);
+    old_mode = state->mode;
+    if (sw->id == 1)
+        state->direction = !state->direction;  // 개별 모드: 누를 때마다 방향 전환
+    if (led_apply_mode(panel, sw->id))
+        led_commit(panel);
+    mode = state->mode;
+    led_pm_update(panel);
+
+    write_sequnlock_irq(&panel->lock);
+    led_flush(panel);
+    // 출력 핀에 반영된 시각: 이벤트로도 내보내 사용자 공간이 엣지 -> LED 지연을 직접 잼
+    done = ktime_get();
+    pm_runtime_mark_last_busy(panel->dev);
+    pm_runtime_put_autosuspend(panel->dev);
+    led_stat_hist(panel, press_hist, ktime_to_ns(ktime_sub(done, sw->last_time)));
+
+    trace_led_mode_change(panel->id, sw->id, old_mode, mode);
+    ledctl_post_event(panel, sw->id, sw->last_time, done, mode);
+    // 하드웨어 디바운스는 떼어짐을 볼 수 없지만 재생되는 바운스 엣지도 없으므로 처리가 끝나면 내림
+    if (sw->hw_debounce)
+        clear_bit(LED_SW_WAKE_REPORTED, &sw->wake);
+
+out:
+    led_stat_hist_since(panel, thread_hist, t0);
+    trace_led_switch_thread_exit(panel->id, sw->id);
+    return IRQ_HANDLED;
+}
+
+// 현재 패턴의 한 단계를 출력하고 인덱스만 하나 증가 (panel->lock 쓰기 구간 안에서 호출)
+// 다음 단계까지의 간격을 돌려주고, 0 이면 더 진행할 것이 없음
+static ktime_t led_panel_step(struct led_panel *panel) {
+    struct led_state *state = &panel->state;
+    const struct led_pattern *pat;
+    const struct led_step *step;
+    DECLARE_BITMAP(prev, LED_MAX_LEDS);
+    unsigned long *cur;
+    int loop_len;
+
+    led_assert_locked(panel);
+
+    if (state->mode == LED_MODE_STREAM) {
+        led_stream_step(panel);
+        return led_tick_period(panel);
+    }
+
+    // 유효하지 않은 모드에서는 타이머 동작 중지
+    pat = state->pattern;
+    if (!pat || state->step >= pat->len)
+        return 0;
+
+    step = &pat->steps[state->step];
+    bitmap_copy(prev, state->leds, panel->num_leds);
+    cur = pat->ordered ? state->chase : state->leds;
+    switch (step->op) {
+        case LED_OP_XOR:
+            bitmap_xor(cur, cur, step->mask, panel->num_leds);
+            break;
+        case LED_OP_ROTATE:
+            led_bitmap_rotate(cur, cur, step->shift, panel->num_leds);
+            break;
+        default:
+            bitmap_copy(cur, step->mask, panel->num_leds);
+            break;
+    }
+
+    // 논리 순서를 물리 LED 로: 켜진 비트 수만큼만 옮기므로 머리 수에 비례
+    if (pat->ordered) {
+        unsigned int i;
+
+        bitmap_zero(state->leds, panel->num_leds);
+        for_each_set_bit(i, state->chase, panel->num_leds)
+            __set_bit(panel->order[i], state->leds);
+    }
+
+    // 반복 구간의 모든 단계가 연속으로 출력을 바꾸지 못했다면 이후로도 영원히 같음
+    if (bitmap_equal(prev, state->leds, panel->num_leds))
+        state->still = state->step >= pat->loop ? state->still + 1 : 0;
+    else {
+        state->still = 0;
+        led_commit(panel);
+    }
+
+    if (++state->step == pat->len)
+        state->step = pat->loop;
+
+    // 정적인 출력이면 타이머를 다시 걸지 않음: 다음 스위치 IRQ 나 사용자 공간 갱신이 시작
+    // 한 번만 재생하는 패턴 (loop == len) 은 마지막 단계까지 진행한 뒤에 멈춤
+    loop_len = pat->len - pat->loop;
+    if (state->step == pat->len || (loop_len && state->still >= loop_len))
+        return 0;
+
+    return step->duration_us ? us_to_ktime(step->duration_us) : led_tick_period(panel);
+}
+
+// 패널별 독립 타이머 (sync_tick=0)
+static enum hrtimer_restart led_timer_callback(struct hrtimer *timer) {
+    struct led_panel *panel = container_of(timer, struct led_panel, led_timer);
+    enum hrtimer_restart ret = HRTIMER_NORESTART;
+    ktime_t due = hrtimer_get_expires(timer);
+    ktime_t now = hrtimer_cb_get_time(timer);
+    u64 t0 = led_stat_clock();
+    ktime_t next;
+
+    trace_led_tick(panel->id, due, now);
+
+    write_seqlock(&panel->lock);
+
+    // 지난 틱 이후 쌓인 사용자 공간 명령을 먼저 적용
+    if (led_cmd_drain(panel))
+        led_commit(panel);
+    next = led_panel_step(panel);
+
+    // 만료 시각 기준으로 재설정하므로 콜백 지연이 누적되지 않음
+    // 그 사이 스위치 핸들러가 타이머를 다시 시작했다면 그 설정을 유지
+    if (next) {
+        ret = HRTIMER_RESTART;
+        if (!hrtimer_is_queued(timer))
+            hrtimer_forward_now(timer, next);
+    }
+
+    write_sequnlock(&panel->lock);
+    led_flush(panel);
+
+    // forward 뒤의 만료 시각은 다음 틱이므로 진입 때 읽은 예정 시각으로 지연을 잰다
+    led_stat_tick(panel, due, now, t0);
+    return ret;
+}
+
+// 공유 타이머 (sync_tick=1): 격자 시각마다 한 번 깨어나 시각이 된 패널만 한 단계씩 진행
+// 같은 간격의 패턴은 모두 같은 격자 틱에서 바뀌므로 패널 사이 위상이 어긋나지 않음
+static enum hrtimer_restart led_sync_timer_callback(struct hrtimer *timer) {
+    ktime_t grid = hrtimer_get_expires(timer);
+    ktime_t period = us_to_ktime(READ_ONCE(tick_period_us));
+    ktime_t now = hrtimer_cb_get_time(timer);
+    enum hrtimer_restart ret = HRTIMER_NORESTART;
+    struct led_panel *panel;
+    ktime_t next, due;
+    bool stepped;
+    u64 t0 = 0;
+
+    rcu_read_lock();
+    list_for_each_entry_rcu(panel, &led_sync_panels, sync_node) {
+        stepped = false;
+        write_seqlock(&panel->lock);
+        // 멈춘 패널의 명령은 cmd_work 가 프로세스 컨텍스트에서 적용 (런타임 resume 필요)
+        if (panel->sync_running && led_cmd_drain(panel))
+            led_commit(panel);
+        // 반 틱 이내로 남은 단계는 이번 격자 틱에 처리 (격자보다 짧은 간격은 틱 단위로 올림)
+        due = panel->sync_due;
+        if (panel->sync_running && ktime_compare(ktime_add(grid, period / 2), due) >= 0) {
+            stepped = true;
+            t0 = led_stat_clock();
+            trace_led_tick(panel->id, due, now);
+            next = led_panel_step(panel);
+            if (next) {
+                panel->sync_due = ktime_add(panel->sync_due, next);
+                if (ktime_before(panel->sync_due, grid))
+                    panel->sync_due = ktime_add(grid, next);
+            } else {
+                led_sync_stop(panel);
+            }
+        }
+        write_sequnlock(&panel->lock);
+        led_flush(panel);
+        if (stepped)
+            led_stat_tick(panel, due, now, t0);
+    }
+    rcu_read_unlock();
+
+    spin_lock(&led_sync_lock);
+    if (led_sync_users) {
+        ret = HRTIMER_RESTART;
+        if (!hrtimer_is_queued(timer))
+            hrtimer_forward_now(timer, period);
+    }
+    spin_unlock(&led_sync_lock);
+
+    return ret;
+}
+
+// devm 이 IRQ 를 해제하기 전에 affinity hint 를 비움 (남아 있으면 free_irq 가 경고)
+static void switch_clear_affinity(void *data) {
+    struct led_switch *sw = data;
+
+    irq_set_affinity_hint(sw->irq, NULL);
+}
+
+// 스위치 하나를 준비: 디바운스 타이머와 스레드 IRQ (핀은 probe 가 switch-gpios 전체를 한 번에 확보)
+static int switch_setup(struct led_panel *panel, int i, struct gpio_desc *desc) {
+    struct device *dev = panel->dev;
+    struct led_switch *sw = &panel->switches[i];
+    unsigned long flags = IRQF_TRIGGER_RISING | IRQF_ONESHOT;
+    int ret;
+
+    sw->panel = panel;
+    sw->id = i;
+    sw->desc = desc;
+
+    hrtimer_init(&sw->debounce_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+    sw->debounce_timer.function = switch_debounce_callback;
+    sw->hw_debounce = !gpiod_set_debounce(sw->desc, panel->debounce_us);
+
+    sw->irq = gpiod_to_irq(sw->desc);
+    if (sw->irq < 0)
+        return dev_err_probe(dev, sw->irq, "Failed to get IRQ for Switch GPIO %d\n", i);
+
+    ret = devm_request_threaded_irq(dev, sw->irq, switch_handler, switch_thread_handler,
+                                    flags, "switch_handler", sw);
+    if (ret)
+        return dev_err_probe(dev, ret, "Failed to request IRQ for Switch GPIO %d\n", i);
+    // sysfs 의 cpu 가 나중에 hint 를 걸 수 있으므로 고정 여부와 상관없이 등록
+    ret = devm_add_action_or_reset(dev, switch_clear_affinity, sw);
+    if (ret)
+        return ret;
+    // 스레드 핸들러는 IRQ affinity 를 따라가므로 함께 고정됨
+    if (panel->cpu >= 0)
+        irq_set_affinity_hint(sw->irq, cpumask_of(panel->cpu));
+    return 0;
+}
+
+// 스위치를 멈춤: 디바운스 타이머가 IRQ 를 다시 enable 하지 않도록 IRQ 부터 끔
+// IRQ 와 GPIO 반납은 devm 이 remove (또는 probe 실패) 뒤에 처리
+static void switch_quiesce(struct led_switch *sw) {
+    disable_irq(sw->irq);
+    hrtimer_cancel(&sw->debounce_timer);
+}
+
+// 패널을 타이머에서 완전히 떼어냄 (프로세스 컨텍스트, 스위치 IRQ 를 막은 뒤)
+static void led_timer_cancel(struct led_panel *panel) {
+    if (!sync_tick) {
+        hrtimer_cancel(&panel->led_timer);
+        return;
+    }
+
+    write_seqlock_irq(&panel->lock);
+    led_sync_stop(panel);
+    write_sequnlock_irq(&panel->lock);
+
+    spin_lock_irq(&led_sync_lock);
+    list_del_rcu(&panel->sync_node);
+    spin_unlock_irq(&led_sync_lock);
+    // 공유 타이머 콜백이 아직 이 패널을 순회 중일 수 있음
+    synchronize_rcu();
+}
+
+// map 이 0 - n-1 의 순열이면 panel->order 로 복사 (probe 또는 panel->lock 쓰기 구간 안에서 호출)
+static void led_order_set(struct led_panel *panel, const u32 *map) {
+    int i;
+
+    panel->ordered = false;
+    for (i = 0; i < panel->num_leds; i++) {
+        panel->order[i] = map ? map[i] : i;
+        if (panel->order[i] != i)
+            panel->ordered = true;
+    }
+}
+
+static int led_order_check(const u32 *map, int n) {
+    DECLARE_BITMAP(seen, LED_MAX_LEDS);
+    int i;
+
+    bitmap_zero(seen, n);
+    for (i = 0; i < n; i++) {
+        if (map[i] >= n || __test_and_set_bit(map[i], seen))
+            return -EINVAL;
+    }
+    return 0;
+}
+
+// 추적 모드 설정: "chase-heads" (기본 1), "chase-order" (논리 위치 i 에 놓인 LED 번호)
+// 배선 순서와 실제 배치가 다른 패널도 화면상 한 방향으로 흐르게 할 수 있음
+static int led_chase_setup(struct led_panel *panel) {
+    struct device *dev = panel->dev;
+    int n = panel->num_leds;
+    u32 heads = 1, *map;
+    int ret;
+
+    device_property_read_u32(dev, "chase-heads", &heads);
+    if (!heads || heads > n) {
+        dev_err(dev, "chase-heads must be 1 - %d\n", n);
+        return -EINVAL;
+    }
+    panel->chase_heads = heads;
+
+    led_order_set(panel, NULL);
+    if (!device_property_present(dev, "chase-order"))
+        return 0;
+
+    if (device_property_count_u32(dev, "chase-order") != n) {
+        dev_err(dev, "chase-order must list all %d LEDs\n", n);
+        return -EINVAL;
+    }
+    map = kcalloc(n, sizeof(*map), GFP_KERNEL);
+    if (!map)
+        return -ENOMEM;
+
+    ret = device_property_read_u32_array(dev, "chase-order", map, n);
+    if (!ret)
+        ret = led_order_check(map, n);
+    if (ret)
+        dev_err(dev, "chase-order must be a permutation of 0 - %d\n", n - 1);
+    else
+        led_order_set(panel, map);
+    kfree(map);
+    return ret;
+}
+
+static void led_panel_free(struct kref *ref) {
+    struct led_panel *panel = container_of(ref, struct led_panel, ref);
+    struct led_cmd cmd;
+
+    // remove 직후에 들어온 명령이 남아 있을 수 있음 (적용하지 않고 패턴만 해제)
+    cancel_work_sync(&panel->cmd_work);
+    while (kfifo_get(&panel->cmds, &cmd))
+        kfree(cmd.pat);
+
+    vfree(panel->stream_ring);
+    kfree(panel->spi.buf[1]);
+    kfree(panel->spi.buf[0]);
+    kfree(panel->hwpwm.chan);
+    kfree(panel->pwm.edges);
+    kfree(panel->gpio_led_map);
+    kfree(panel->led_descs);
+    kfree(panel->color);
+    kfree(panel->order);
+    kfree(panel->fade.to);
+    kfree(panel->fade.from);
+    kfree(panel->level);
+    kfree(panel->brightness);
+    kfree(panel->patterns);
+    free_percpu(panel->stats);
+    ida_free(&led_panel_ida, panel->id);
+    kfree(panel);
+}
+
+// probe 가 잡은 참조 (devm 동작)
+static void led_panel_put(void *data) {
+    struct led_panel *panel = data;
+
+    kref_put(&panel->ref, led_panel_free);
+}
+
+static int ledctl_open(struct inode *inode, struct file *file) {
+    struct led_panel *panel = container_of(file->private_data, struct led_panel, misc);
+    struct ledctl_client *client;
+
+    client = kzalloc(sizeof(*client), GFP_KERNEL);
+    if (!client)
+        return -ENOMEM;
+
+    client->panel = panel;
+    INIT_KFIFO(client->events);
+    spin_lock_init(&client->lock);
+    mutex_init(&client->read_lock);
+    init_waitqueue_head(&client->wait);
+
+    kref_get(&panel->ref);
+    spin_lock(&panel->clients_lock);
+    list_add_tail_rcu(&client->node, &panel->clients);
+    spin_unlock(&panel->clients_lock);
+
+    file->private_data = client;
+    return 0;
+}
+
+static int ledctl_release(struct inode *inode, struct file *file) {
+    struct ledctl_client *client = file->private_data;
+    struct led_panel *panel = client->panel;
+
+    spin_lock(&panel->clients_lock);
+    list_del_rcu(&client->node);
+    spin_unlock(&panel->clients_lock);
+
+    // 스위치 스레드가 아직 순회 중일 수 있으므로 RCU 유예 후 해제
+    kfree_rcu(client, rcu);
+    kref_put(&panel->ref, led_panel_free);
+    return 0;
+}
+
+// 이벤트 단위로만 읽음, O_NONBLOCK 이면 비어 있을 때 -EAGAIN
+static ssize_t ledctl_read(struct file *file, char __user *buf, size_t count, loff_t *ppos) {
+    struct ledctl_client *client = file->private_data;
+    unsigned int copied;
+    int ret;
+
+    if (count < sizeof(struct ledctl_event))
+        return -EINVAL;
+
+    for (;;) {
+        ret = mutex_lock_interruptible(&client->read_lock);
+        if (ret)
+            return ret;
+        if (!kfifo_is_empty(&client->events))
+            break;
+        mutex_unlock(&client->read_lock);
+
+        if (file->f_flags & O_NONBLOCK)
+            return -EAGAIN;
+        ret = wait_event_interruptible(client->wait, !kfifo_is_empty(&client->events));
+        if (ret)
+            return ret;
+    }
+
+    ret = kfifo_to_user(&client->events, buf, count, &copied);
+    mutex_unlock(&client->read_lock);
+
+    return ret ? ret : copied;
+}
+
+static __poll_t ledctl_poll(struct file *file, poll_table *wait) {
+    struct ledctl_client *client = file->private_data;
+
+    poll_wait(file, &client->wait, wait);
+
+    return kfifo_is_empty(&client->events) ? 0 : EPOLLIN | EPOLLRDNORM;
+}
+
+static long ledctl_ioctl(struct file *file, unsigned int cmd, unsigned long arg) {
+    struct ledctl_client *client = file->private_data;
+    struct led_panel *panel = client->panel;
+    long ret = 0;
+    u32 us, val;
+
+    switch (cmd) {
+        // 모드 변경은 명령 링에 넣고 바로 돌아옴 (다음 틱 시작에서 적용)
+        case LEDCTL_START:
+        case LEDCTL_STOP:
+            return led_cmd_post(panel, LED_CMD_STREAM, cmd == LEDCTL_START, NULL);
+
+        case LEDCTL_SET_MODE:
+        case LEDCTL_SET_DIRECTION:
+            ret = get_user(val, (u32 __user *)arg);
+            if (ret)
+                return ret;
+            if (cmd == LEDCTL_SET_MODE ? val > 3 : val > 1)
+                return -EINVAL;
+            return led_cmd_post(panel, cmd == LEDCTL_SET_MODE ? LED_CMD_MODE : LED_CMD_DIRECTION,
+                                val, NULL);
+
+        // 주기는 WRITE_ONCE 한 번이라 원래 lock 을 잡지 않음
+        case LEDCTL_SET_PERIOD:
+            ret = get_user(us, (u32 __user *)arg);
+            if (ret)
+                return ret;
+            return led_set_tick_period(panel, us);
+
+        default:
+            return -ENOTTY;
     }
 }
 
-static void set_led(int led_idx, int value) {
-    if (led_idx >= 0 && led_idx < NUM_LEDS) {
-        gpio_set_value(led_pins[led_idx], value);
-        led_states[led_idx] = value;
+// 프레임 링을 사용자 공간에 그대로 매핑 (프레임마다 시스템 콜 불필요)
+static int ledctl_mmap(struct file *file, struct vm_area_struct *vma) {
+    struct ledctl_client *client = file->private_data;
+
+    return remap_vmalloc_range(vma, client->panel->stream_ring, vma->vm_pgoff);
+}
+
+static const struct file_operations ledctl_fops = {
+    .owner = THIS_MODULE,
+    .open = ledctl_open,
+    .release = ledctl_release,
+    .read = ledctl_read,
+    .poll = ledctl_poll,
+    .unlocked_ioctl = ledctl_ioctl,
+    .compat_ioctl = compat_ptr_ioctl,
+    .mmap = ledctl_mmap,
+};
+
+static ssize_t tick_period_us_show(struct device *dev, struct device_attribute *attr, char *buf) {
+    struct led_panel *panel = dev_get_drvdata(dev);
+
+    return sysfs_emit(buf, "%u\n", READ_ONCE(panel->tick_period_us));
+}
+
+static ssize_t tick_period_us_store(struct device *dev, struct device_attribute *attr,
+                                    const char *buf, size_t count) {
+    struct led_panel *panel = dev_get_drvdata(dev);
+    unsigned int us;
+    int ret;
+
+    ret = kstrtouint(buf, 0, &us);
+    if (ret)
+        return ret;
+
+    ret = led_set_tick_period(panel, us);
+    return ret ? ret : count;
+}
+static DEVICE_ATTR_RW(tick_period_us);
+
+// 하드웨어 디바운스는 probe 시 값으로 고정, 소프트웨어는 다음 엣지부터 반영
+static ssize_t debounce_us_show(struct device *dev, struct device_attribute *attr, char *buf) {
+    struct led_panel *panel = dev_get_drvdata(dev);
+
+    return sysfs_emit(buf, "%u\n", READ_ONCE(panel->debounce_us));
+}
+
+static ssize_t debounce_us_store(struct device *dev, struct device_attribute *attr,
+                                 const char *buf, size_t count) {
+    struct led_panel *panel = dev_get_drvdata(dev);
+    unsigned int us;
+    int ret;
+
+    ret = kstrtouint(buf, 0, &us);
+    if (ret)
+        return ret;
+    if (us < DEBOUNCE_MIN_US || us > DEBOUNCE_MAX_US)
+        return -EINVAL;
+
+    WRITE_ONCE(panel->debounce_us, us);
+    return count;
+}
+static DEVICE_ATTR_RW(debounce_us);
+
+// 스위치 IRQ (와 스레드 핸들러), 패널 타이머를 고정할 CPU, -1 이면 고정 해제
+// 동작 중인 타이머는 새 CPU 에서 다시 시작
+static ssize_t cpu_show(struct device *dev, struct device_attribute *attr, char *buf) {
+    struct led_panel *panel = dev_get_drvdata(dev);
+
+    return sysfs_emit(buf, "%d\n", READ_ONCE(panel->cpu));
+}
+
+static ssize_t cpu_store(struct device *dev, struct device_attribute *attr,
+                         const char *buf, size_t count) {
+    struct led_panel *panel = dev_get_drvdata(dev);
+    int cpu, ret, i;
+
+    ret = kstrtoint(buf, 0, &cpu);
+    if (ret)
+        return ret;
+    if (cpu < -1 || (cpu >= 0 && (cpu >= nr_cpu_ids || !cpu_online(cpu))))
+        return -EINVAL;
+
+    WRITE_ONCE(panel->cpu, cpu);
+    for (i = 0; i < NUM_SWITCHES; i++)
+        irq_set_affinity_hint(panel->switches[i].irq, cpu >= 0 ? cpumask_of(cpu) : NULL);
+
+    write_seqlock_irq(&panel->lock);
+    if (hrtimer_is_queued(&panel->led_timer))
+        led_hrtimer_start(panel, LED_KICK_TIMER);
+    if (hrtimer_is_queued(&panel->pwm_timer))
+        led_hrtimer_start(panel, LED_KICK_PWM);
+    write_sequnlock_irq(&panel->lock);
+
+    return count;
+}
+static DEVICE_ATTR_RW(cpu);
+
+// LED 별 밝기 (0-255): "b0,b1,...,bN-1" 또는 전체에 같은 값 하나
+static ssize_t brightness_show(struct device *dev, struct device_attribute *attr, char *buf) {
+    struct led_panel *panel = dev_get_drvdata(dev);
+    int i, len = 0;
+
+    for (i = 0; i < panel->num_leds; i++)
+        len += sysfs_emit_at(buf, len, "%s%u", i ? "," : "", READ_ONCE(panel->brightness[i]));
+    len += sysfs_emit_at(buf, len, "\n");
+    return len;
+}
+
+static ssize_t brightness_store(struct device *dev, struct device_attribute *attr,
+                                const char *buf, size_t count) {
+    struct led_panel *panel = dev_get_drvdata(dev);
+    u8 levels[LED_MAX_LEDS];
+    char *copy, *cur, *tok;
+    int n = 0, ret = 0;
+
+    copy = kstrdup(buf, GFP_KERNEL);
+    if (!copy)
+        return -ENOMEM;
+
+    cur = strim(copy);
+    while ((tok = strsep(&cur, ",")) != NULL) {
+        if (n >= panel->num_leds) {
+            ret = -EINVAL;
+            break;
+        }
+        ret = kstrtou8(tok, 0, &levels[n++]);
+        if (ret)
+            break;
     }
+    kfree(copy);
+    if (ret)
+        return ret;
+
+    if (n == 1)
+        memset(levels, levels[0], panel->num_leds);
+    else if (n != panel->num_leds)
+        return -EINVAL;
+
+    write_seqlock_irq(&panel->lock);
+    memcpy(panel->brightness, levels, panel->num_leds);
+    pwm_apply(panel);
+    write_sequnlock_irq(&panel->lock);
+    led_flush(panel);
+
+    return count;
 }
+static DEVICE_ATTR_RW(brightness);
 
-static irqreturn_t switch_handler(int irq, void *dev_id) {
-    int switch_id = (int)(long)dev_id;
-    unsigned long current_time = jiffies;
+// 패턴 출력이 바뀔 때 밝기를 보간할 시간 (us, 0 이면 즉시 전환)
+static ssize_t fade_us_show(struct device *dev, struct device_attribute *attr, char *buf) {
+    struct led_panel *panel = dev_get_drvdata(dev);
+
+    return sysfs_emit(buf, "%u\n", READ_ONCE(panel->fade.duration_us));
+}
+
+static ssize_t fade_us_store(struct device *dev, struct device_attribute *attr,
+                             const char *buf, size_t count) {
+    struct led_panel *panel = dev_get_drvdata(dev);
+    unsigned int us;
+    int ret, i;
+
+    ret = kstrtouint(buf, 0, &us);
+    if (ret)
+        return ret;
+    if (us > FADE_MAX_US)
+        return -ERANGE;
 
-    // 디바운스 처리
-    if (current_time - last_switch_time[switch_id] < DEBOUNCE_DELAY) {
-        return IRQ_HANDLED;
+    write_seqlock_irq(&panel->lock);
+    // 페이드를 켜면 꺼져 있는 LED 의 듀티부터 0 으로 맞춰 둠 (level 이 상태를 반영하도록)
+    if (!panel->fade.duration_us && us) {
+        for (i = 0; i < panel->num_leds; i++) {
+            if (!test_bit(i, panel->state.leds))
+                panel->level[i] = 0;
+        }
     }
-    last_switch_time[switch_id] = current_time;
+    WRITE_ONCE(panel->fade.duration_us, us);
+    panel->fade.active = false;
+    pwm_apply(panel);
+    write_sequnlock_irq(&panel->lock);
+    led_flush(panel);
 
-    mutex_lock(&mode_lock);
+    return count;
+}
+static DEVICE_ATTR_RW(fade_us);
 
-    switch (switch_id) {
-        case 0: // 전체 모드
-            current_mode = 0;
-            del_timer(&led_timer);
-            timer_setup(&led_timer, led_timer_callback, 0);
-            mod_timer(&led_timer, jiffies + HZ * 2);
-            break;
+// LED 별 색 (RGB 스트립만, 다른 패널에는 속성이 없음): 16진수 "rrggbb,..." 또는 전체에 같은 값 하나
+static ssize_t color_show(struct device *dev, struct device_attribute *attr, char *buf) {
+    struct led_panel *panel = dev_get_drvdata(dev);
+    int i, len = 0;
 
-        case 1: // 개별 모드
-            current_mode = 1;
-            direction = !direction; 
-            current_led = (direction == 0) ? 0 : NUM_LEDS - 1; 
-            del_timer(&led_timer);
-            timer_setup(&led_timer, led_timer_callback, 0);
-            mod_timer(&led_timer, jiffies + HZ * 2);
-            break;
+    for (i = 0; i < panel->num_leds; i++)
+        len += sysfs_emit_at(buf, len, "%s%06x", i ? "," : "", READ_ONCE(panel->color[i]));
+    len += sysfs_emit_at(buf, len, "\n");
+    return len;
+}
 
-        case 2: // 수동 모드
-            current_mode = 2;
-            break;
+static ssize_t color_store(struct device *dev, struct device_attribute *attr,
+                           const char *buf, size_t count) {
+    struct led_panel *panel = dev_get_drvdata(dev);
+    char *copy, *cur, *tok;
+    int i, n = 0, ret = 0;
+    u32 *colors;
 
-        case 3: // 리셋 모드
-            reset_leds();
-            current_mode = -1;
-            del_timer(&led_timer);
-            break;
+    colors = kmalloc_array(panel->num_leds, sizeof(*colors), GFP_KERNEL);
+    copy = kstrdup(buf, GFP_KERNEL);
+    if (!colors || !copy) {
+        ret = -ENOMEM;
+        goto out;
+    }
+
+    cur = strim(copy);
+    while ((tok = strsep(&cur, ",")) != NULL) {
+        if (n >= panel->num_leds) {
+            ret = -EINVAL;
+            goto out;
+        }
+        ret = kstrtou32(tok, 16, &colors[n]);
+        if (ret)
+            goto out;
+        if (colors[n++] > LED_COLOR_WHITE) {
+            ret = -ERANGE;
+            goto out;
+        }
+    }
+    if (n == 1) {
+        for (i = 1; i < panel->num_leds; i++)
+            colors[i] = colors[0];
+    } else if (n != panel->num_leds) {
+        ret = -EINVAL;
+        goto out;
     }
 
-    mutex_unlock(&mode_lock);
+    // 색은 encode 가 lock 없이 읽으므로 LED 하나씩 WRITE_ONCE
+    write_seqlock_irq(&panel->lock);
+    for (i = 0; i < panel->num_leds; i++)
+        WRITE_ONCE(panel->color[i], colors[i]);
+    led_commit(panel);
+    write_sequnlock_irq(&panel->lock);
+    led_flush(panel);
+    ret = count;
 
-    return IRQ_HANDLED;
+out:
+    kfree(copy);
+    kfree(colors);
+    return ret;
 }
+static DEVICE_ATTR_RW(color);
 
-static void led_timer_callback(struct timer_list *timer) {
-    mutex_lock(&mode_lock);
-    int i;
+// 추적 패턴을 새 설정으로 다시 만들고 모드 1 이면 처음부터 재생 (panel->lock 쓰기 구간 안에서 호출)
+static void led_chase_apply(struct led_panel *panel) {
+    led_chase_init(panel);
+    if (panel->state.mode == 1)
+        led_apply_mode(panel, 1);
+}
 
-    switch (current_mode) {
-        case 0: // 전체 모드
-            if (!led_states[0]) { 
-                // 모든 LED 켜기
-                for (i = 0; i < NUM_LEDS; i++) {
-                    set_led(i, 1);
-                }
-            } else {
-                // 모든 LED 끄기
-                reset_leds();
-            }
-            // 타이머 재설정
-            mod_timer(&led_timer, jiffies + HZ * 2);
-            break;
+// 추적 모드에서 같은 간격으로 함께 움직이는 LED 수 (1 - num_leds)
+static ssize_t chase_heads_show(struct device *dev, struct device_attribute *attr, char *buf) {
+    struct led_panel *panel = dev_get_drvdata(dev);
 
-        case 1: // 개별 모드
-            set_led(current_led, 0); // 이전 LED 끄기
-            current_led = (direction == 0) 
-                ? (current_led - 1 + NUM_LEDS) % NUM_LEDS
-		: (current_led + 1) % NUM_LEDS;
-            set_led(current_led, 1); // 현재 LED 켜기
-            mod_timer(&led_timer, jiffies + HZ * 2);
-            break;
+    return sysfs_emit(buf, "%u\n", READ_ONCE(panel->chase_heads));
+}
 
-        case 2: // 수동 모드
-            for (i = 0; i < NUM_LEDS; i++) {
-                set_led(i, led_states[i] ? 0 : 1); // LED 토글
-            }
-            mod_timer(&led_timer, jiffies + HZ * 2);
-            break;
+static ssize_t chase_heads_store(struct device *dev, struct device_attribute *attr,
+                                 const char *buf, size_t count) {
+    struct led_panel *panel = dev_get_drvdata(dev);
+    unsigned int heads;
+    int ret;
 
-        default:
-            // 유효하지 않은 모드에서는 타이머 동작 중지
-            del_timer(&led_timer);
-            break;
+    ret = kstrtouint(buf, 0, &heads);
+    if (ret)
+        return ret;
+    if (!heads || heads > panel->num_leds)
+        return -EINVAL;
+
+    write_seqlock_irq(&panel->lock);
+    WRITE_ONCE(panel->chase_heads, heads);
+    led_chase_apply(panel);
+    write_sequnlock_irq(&panel->lock);
+    led_flush(panel);
+
+    return count;
+}
+static DEVICE_ATTR_RW(chase_heads);
+
+// 추적 순서: "o0,o1,...,oN-1" (논리 위치 i 에 놓인 LED 번호), 빈 값이면 배선 순서
+static ssize_t chase_order_show(struct device *dev, struct device_attribute *attr, char *buf) {
+    struct led_panel *panel = dev_get_drvdata(dev);
+    unsigned int seq;
+    int i, len;
+
+    do {
+        seq = read_seqbegin(&panel->lock);
+        len = 0;
+        for (i = 0; i < panel->num_leds; i++)
+            len += sysfs_emit_at(buf, len, "%s%u", i ? "," : "", panel->order[i]);
+    } while (read_seqretry(&panel->lock, seq));
+
+    len += sysfs_emit_at(buf, len, "\n");
+    return len;
+}
+
+static ssize_t chase_order_store(struct device *dev, struct device_attribute *attr,
+                                 const char *buf, size_t count) {
+    struct led_panel *panel = dev_get_drvdata(dev);
+    char *copy, *cur, *tok;
+    int n = 0, ret = 0;
+    u32 *map;
+
+    map = kcalloc(panel->num_leds, sizeof(*map), GFP_KERNEL);
+    copy = kstrdup(buf, GFP_KERNEL);
+    if (!map || !copy) {
+        ret = -ENOMEM;
+        goto out;
+    }
+
+    cur = strim(copy);
+    if (!*cur)
+        cur = NULL;
+    while ((tok = strsep(&cur, ",")) != NULL) {
+        if (n >= panel->num_leds) {
+            ret = -EINVAL;
+            goto out;
+        }
+        ret = kstrtou32(tok, 0, &map[n++]);
+        if (ret)
+            goto out;
     }
+    if (n && (n != panel->num_leds || led_order_check(map, n))) {
+        ret = -EINVAL;
+        goto out;
+    }
+
+    write_seqlock_irq(&panel->lock);
+    led_order_set(panel, n ? map : NULL);
+    led_chase_apply(panel);
+    write_sequnlock_irq(&panel->lock);
+    led_flush(panel);
 
-    mutex_unlock(&mode_lock);
+out:
+    kfree(copy);
+    kfree(map);
+    return ret ? ret : count;
 }
+static DEVICE_ATTR_RW(chase_order);
 
-static int __init led_module_init(void) {
-    int ret, i;
-    unsigned long flags = IRQF_TRIGGER_RISING | IRQF_ONESHOT;
+// 사용자 패턴: "[^]hexmask[@us] | <n[@us] ...", 쓰면 다음 틱부터 모드 3 으로 재생
+static ssize_t pattern_show(struct device *dev, struct device_attribute *attr, char *buf) {
+    struct led_panel *panel = dev_get_drvdata(dev);
+    const struct led_pattern *pat = &panel->patterns[LED_PAT_USER];
+    unsigned int seq;
+    int i, len;
 
-    mutex_init(&mode_lock);
+    do {
+        seq = read_seqbegin(&panel->lock);
+        len = 0;
+        for (i = 0; i < pat->len; i++) {
+            const struct led_step *step = &pat->steps[i];
 
-    // LED 핀 초기화 with comprehensive error handling
-    for (i = 0; i < NUM_LEDS; i++) {
-        ret = gpio_request(led_pins[i], "LED");
-        if (ret) {
-            printk(KERN_ERR "Failed to request LED GPIO %d\n", led_pins[i]);
-            goto led_init_error;
+            if (i)
+                len += sysfs_emit_at(buf, len, " ");
+            if (i && i == pat->loop)
+                len += sysfs_emit_at(buf, len, "| ");
+            if (step->op == LED_OP_ROTATE)
+                len += sysfs_emit_at(buf, len, "%c%d", step->shift < 0 ? '<' : '>',
+                                     abs(step->shift));
+            else
+                len += sysfs_emit_at(buf, len, "%s%*pb", step->op == LED_OP_XOR ? "^" : "",
+                                     panel->num_leds, step->mask);
+            if (step->duration_us)
+                len += sysfs_emit_at(buf, len, "@%u", step->duration_us);
         }
-        gpio_direction_output(led_pins[i], 0);
+        if (pat->len && pat->loop == pat->len)
+            len += sysfs_emit_at(buf, len, " |");
+    } while (read_seqretry(&panel->lock, seq));
+
+    len += sysfs_emit_at(buf, len, "\n");
+    return len;
+}
+
+static ssize_t pattern_store(struct device *dev, struct device_attribute *attr,
+                             const char *buf, size_t count) {
+    struct led_panel *panel = dev_get_drvdata(dev);
+    struct led_pattern *pat;
+    char *copy;
+    int ret;
+
+    pat = kzalloc(sizeof(*pat), GFP_KERNEL);
+    copy = kstrdup(buf, GFP_KERNEL);
+    if (!pat || !copy) {
+        ret = -ENOMEM;
+        goto out;
     }
 
-    // 스위치 핀 초기화 및 IRQ 설정 with comprehensive error handling
-    for (i = 0; i < NUM_SWITCHES; i++) {
-        ret = gpio_request(switch_pins[i], "Switch");
-        if (ret) {
-            printk(KERN_ERR "Failed to request Switch GPIO %d\n", switch_pins[i]);
-            goto switch_init_error;
+    ret = led_pattern_parse(copy, pat, panel->num_leds);
+    if (ret)
+        goto out;
+
+    // 적용은 다음 틱에서, 성공하면 pat 은 꺼낸 쪽이 해제
+    ret = led_cmd_post(panel, LED_CMD_PATTERN, 0, pat);
+    if (!ret)
+        pat = NULL;
+
+out:
+    kfree(copy);
+    kfree(pat);
+    return ret ? ret : count;
+}
+static DEVICE_ATTR_RW(pattern);
+
+#ifdef LED_INSTRUMENT
+static struct dentry *led_debugfs_root;
+
+// debugfs 의 led_panel/panelN/stats: "이름 값" 한 줄씩, 히스토그램은 비어 있지 않은 버킷만
+static void led_stats_hist_show(struct seq_file *m, struct led_panel *panel, const char *name,
+                                size_t offset) {
+    u64 sum;
+    int b, cpu;
+
+    for (b = 0; b < LED_HIST_BUCKETS; b++) {
+        sum = 0;
+        for_each_possible_cpu(cpu) {
+            const u64 *hist = (const void *)per_cpu_ptr(panel->stats, cpu) + offset;
+
+            sum += hist[b];
         }
-        gpio_direction_input(switch_pins[i]);
-        
-        irq_numbers[i] = gpio_to_irq(switch_pins[i]);
-        if (irq_numbers[i] < 0) {
-            printk(KERN_ERR "Failed to get IRQ for GPIO %d\n", switch_pins[i]);
-            ret = irq_numbers[i];
-            goto switch_init_error;
+        if (sum)
+            seq_printf(m, "%s_ns_log2_%d %llu\n", name, b, sum);
+    }
+}
+
+static int led_stats_show(struct seq_file *m, void *v) {
+    struct led_panel *panel = m->private;
+    struct led_stats total = {};
+    int cpu, i;
+
+    for_each_possible_cpu(cpu) {
+        const struct led_stats *st = per_cpu_ptr(panel->stats, cpu);
+
+        for (i = 0; i < NUM_SWITCHES; i++) {
+            total.irqs[i] += st->irqs[i];
+            total.debounce_drops[i] += st->debounce_drops[i];
         }
-        
-        ret = request_irq(irq_numbers[i], switch_handler, flags, "switch_handler", (void *)(long)i);
-        if (ret) {
-            printk(KERN_ERR "Failed to request IRQ for GPIO %d\n", switch_pins[i]);
+        total.ticks += st->ticks;
+        total.pwm_ticks += st->pwm_ticks;
+        total.tick_late_sum_ns += st->tick_late_sum_ns;
+        total.tick_late_max_ns = max(total.tick_late_max_ns, st->tick_late_max_ns);
+    }
+
+    for (i = 0; i < NUM_SWITCHES; i++) {
+        seq_printf(m, "switch%d_irqs %llu\n", i, total.irqs[i]);
+        seq_printf(m, "switch%d_debounce_drops %llu\n", i, total.debounce_drops[i]);
+    }
+    seq_printf(m, "ticks %llu\n", total.ticks);
+    seq_printf(m, "pwm_ticks %llu\n", total.pwm_ticks);
+    seq_printf(m, "tick_late_avg_ns %llu\n",
+               total.ticks ? div64_u64(total.tick_late_sum_ns, total.ticks) : 0);
+    seq_printf(m, "tick_late_max_ns %llu\n", total.tick_late_max_ns);
+    seq_printf(m, "tick_late_sum_ns %llu\n", total.tick_late_sum_ns);
+    led_stats_hist_show(m, panel, "irq", offsetof(struct led_stats, irq_hist));
+    led_stats_hist_show(m, panel, "thread", offsetof(struct led_stats, thread_hist));
+    led_stats_hist_show(m, panel, "tick", offsetof(struct led_stats, tick_hist));
+    led_stats_hist_show(m, panel, "press", offsetof(struct led_stats, press_hist));
+    return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(led_stats);
+
+// debugfs 의 led_panel/panelN/inject: 스위치 번호를 쓰면 눌림 엣지를 하나 주입 (벤치마크용)
+// 칩이 pending 상태 주입을 지원하면 실제 하드웨어 IRQ 로, 아니면 IRQ 흐름 처리기를 직접 호출
+// 어느 쪽이든 하드 IRQ, 디바운스, 스레드 핸들러를 실제 엣지와 똑같이 거침
+static ssize_t led_inject_write(struct file *file, const char __user *ubuf, size_t count,
+                                loff_t *ppos) {
+    struct led_panel *panel = file->private_data;
+    struct led_switch *sw;
+    unsigned int id;
+    int ret;
+
+    ret = kstrtouint_from_user(ubuf, count, 0, &id);
+    if (ret)
+        return ret;
+    if (id >= NUM_SWITCHES)
+        return -EINVAL;
+
+    sw = &panel->switches[id];
+    set_bit(0, &sw->inject);
+    if (irq_set_irqchip_state(sw->irq, IRQCHIP_STATE_PENDING, true))
+        ret = generic_handle_irq_safe(sw->irq);
+    if (ret) {
+        clear_bit(0, &sw->inject);
+        return ret;
+    }
+    return count;
+}
+
+static const struct file_operations led_inject_fops = {
+    .owner = THIS_MODULE,
+    .open = simple_open,
+    .write = led_inject_write,
+    .llseek = noop_llseek,
+};
+
+// debugfs 는 진단용이므로 실패해도 probe 는 계속
+static void led_panel_debugfs_init(struct led_panel *panel) {
+    char name[16];
+
+    snprintf(name, sizeof(name), "panel%d", panel->id);
+    panel->debugfs = debugfs_create_dir(name, led_debugfs_root);
+    debugfs_create_file("stats", 0444, panel->debugfs, panel, &led_stats_fops);
+    debugfs_create_file("inject", 0200, panel->debugfs, panel, &led_inject_fops);
+}
+
+static void led_panel_debugfs_exit(struct led_panel *panel) {
+    debugfs_remove_recursive(panel->debugfs);
+}
+
+// led_panel/diagnostics: 1 이면 통계 수집 (모든 패널 공통)
+static ssize_t led_diag_read(struct file *file, char __user *ubuf, size_t count, loff_t *ppos) {
+    char buf[2] = { static_key_enabled(&led_diag_key) ? '1' : '0', '\n' };
+
+    return simple_read_from_buffer(ubuf, count, ppos, buf, sizeof(buf));
+}
+
+static ssize_t led_diag_write(struct file *file, const char __user *ubuf, size_t count,
+                              loff_t *ppos) {
+    bool on;
+    int ret;
+
+    ret = kstrtobool_from_user(ubuf, count, &on);
+    if (ret)
+        return ret;
+
+    // 코드 패치는 sleep 할 수 있으므로 여기 (프로세스 컨텍스트) 에서만
+    if (on)
+        static_branch_enable(&led_diag_key);
+    else
+        static_branch_disable(&led_diag_key);
+    return count;
+}
+
+static const struct file_operations led_diag_fops = {
+    .owner = THIS_MODULE,
+    .read = led_diag_read,
+    .write = led_diag_write,
+    .llseek = default_llseek,
+};
+
+static void led_debugfs_init(void) {
+    led_debugfs_root = debugfs_create_dir("led_panel", NULL);
+    debugfs_create_file("diagnostics", 0644, led_debugfs_root, NULL, &led_diag_fops);
+}
+
+static void led_debugfs_exit(void) {
+    debugfs_remove_recursive(led_debugfs_root);
+}
+#else
+static inline void led_panel_debugfs_init(struct led_panel *panel) { }
+static inline void led_panel_debugfs_exit(struct led_panel *panel) { }
+static inline void led_debugfs_init(void) { }
+static inline void led_debugfs_exit(void) { }
+#endif
+
+static struct attribute *led_panel_attrs[] = {
+    &dev_attr_tick_period_us.attr,
+    &dev_attr_debounce_us.attr,
+    &dev_attr_cpu.attr,
+    &dev_attr_brightness.attr,
+    &dev_attr_color.attr,
+    &dev_attr_fade_us.attr,
+    &dev_attr_pattern.attr,
+    &dev_attr_chase_heads.attr,
+    &dev_attr_chase_order.attr,
+    NULL,
+};
+
+// dev_groups 는 probe 가 성공한 뒤에 만들어지므로 출력 백엔드가 정해져 있음
+static umode_t led_panel_attr_visible(struct kobject *kobj, struct attribute *attr, int n) {
+    struct led_panel *panel = dev_get_drvdata(kobj_to_dev(kobj));
+
+    if (attr == &dev_attr_color.attr && !panel->color)
+        return 0;
+    return attr->mode;
+}
+
+static const struct attribute_group led_panel_group = {
+    .attrs = led_panel_attrs,
+    .is_visible = led_panel_attr_visible,
+};
+__ATTRIBUTE_GROUPS(led_panel);
+
+// 출력 백엔드와 무관한 공통 probe: dev 는 플랫폼 장치 또는 SPI 장치
+static int led_panel_probe(struct device *dev, const struct led_output_ops *out) {
+    struct gpio_descs *switches;
+    struct led_panel *panel;
+    int ret, i, num_leds;
+
+    num_leds = out->count(dev);
+    if (num_leds < 1 || num_leds > LED_MAX_LEDS || gpiod_count(dev, "switch") != NUM_SWITCHES) {
+        dev_err(dev, "Expected 1-%d LEDs and %d switch-gpios\n", LED_MAX_LEDS, NUM_SWITCHES);
+        return -EINVAL;
+    }
+
+    panel = kzalloc(sizeof(*panel), GFP_KERNEL);
+    if (!panel)
+        return -ENOMEM;
+
+    ret = ida_alloc(&led_panel_ida, GFP_KERNEL);
+    if (ret < 0) {
+        kfree(panel);
+        return ret;
+    }
+    panel->id = ret;
+    panel->dev = dev;
+    panel->out = out;
+    panel->num_leds = num_leds;
+    kref_init(&panel->ref);
+    // 실패 경로의 led_panel_free 도 명령 링을 비우므로 가장 먼저 초기화
+    INIT_KFIFO(panel->cmds);
+    spin_lock_init(&panel->cmd_lock);
+    INIT_WORK(&panel->cmd_work, led_cmd_work_fn);
+    // 가장 먼저 등록한 devm 동작이라 핀, PWM 채널, IRQ 가 모두 반납된 뒤 마지막으로 참조를 놓음
+    ret = devm_add_action_or_reset(dev, led_panel_put, panel);
+    if (ret)
+        return ret;
+
+    // LED 수에 비례하는 배열은 따로 할당해 패널 구조체를 작게 유지
+    panel->patterns = kcalloc(LED_NUM_PATTERNS, sizeof(*panel->patterns), GFP_KERNEL);
+    panel->brightness = kmalloc(num_leds, GFP_KERNEL);
+    panel->level = kzalloc(num_leds, GFP_KERNEL);
+    panel->fade.from = kzalloc(num_leds, GFP_KERNEL);
+    panel->fade.to = kzalloc(num_leds, GFP_KERNEL);
+    // 엣지는 1 ~ LED_BRIGHTNESS_MAX - 1 듀티마다 최대 하나
+    panel->pwm.edges = kcalloc(min(num_leds, LED_BRIGHTNESS_MAX - 1),
+                               sizeof(*panel->pwm.edges), GFP_KERNEL);
+    panel->order = kcalloc(num_leds, sizeof(*panel->order), GFP_KERNEL);
+    panel->stats = alloc_percpu(struct led_stats);
+    if (!panel->patterns || !panel->brightness || !panel->level || !panel->fade.from ||
+        !panel->fade.to || !panel->pwm.edges || !panel->order || !panel->stats) {
+        return -ENOMEM;
+    }
+
+    ret = led_chase_setup(panel);
+    if (ret)
+        return ret;
+
+    seqlock_init(&panel->lock);
+    INIT_LIST_HEAD(&panel->clients);
+    spin_lock_init(&panel->clients_lock);
+    panel->state.mode = -1;
+    panel->tick_period_us = READ_ONCE(tick_period_us);
+    panel->debounce_us = READ_ONCE(debounce_us);
+    panel->cpu = READ_ONCE(led_cpu);
+    if (panel->cpu >= 0 && (panel->cpu >= nr_cpu_ids || !cpu_online(panel->cpu))) {
+        dev_warn(dev, "CPU %d is not online, not pinning\n", panel->cpu);
+        panel->cpu = -1;
+    }
+    memset(panel->brightness, LED_BRIGHTNESS_MAX, num_leds);
+    panel->frame_front = &panel->frames[0];
+    panel->frame_mid = (unsigned long)&panel->frames[1];
+    panel->frame_back = &panel->frames[2];
+    dev_set_drvdata(dev, panel);
+
+    // 타이머 초기화 (IRQ 등록 전에 준비해야 스레드 핸들러가 바로 사용 가능)
+    hrtimer_init(&panel->led_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+    panel->led_timer.function = led_timer_callback;
+    hrtimer_init(&panel->pwm_timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+    panel->pwm_timer.function = pwm_timer_callback;
+    INIT_WORK(&panel->hwpwm.work, hwpwm_work_fn);
+    INIT_WORK(&panel->kick_work, led_kick_fn);
+    led_patterns_init(panel);
+
+    // 스위치 핀은 요청 한 번으로 모두 확보
+    switches = devm_gpiod_get_array(dev, "switch", GPIOD_IN);
+    if (IS_ERR(switches))
+        return dev_err_probe(dev, PTR_ERR(switches), "Failed to request switch GPIOs\n");
+
+    ret = out->setup(panel);
+    if (ret) {
+        dev_err(dev, "Failed to set up %s output\n", out->name);
+        return ret;
+    }
+
+    if (sync_tick) {
+        spin_lock_irq(&led_sync_lock);
+        list_add_tail_rcu(&panel->sync_node, &led_sync_panels);
+        spin_unlock_irq(&led_sync_lock);
+    }
+
+    for (i = 0; i < NUM_SWITCHES; i++) {
+        ret = switch_setup(panel, i, switches->desc[i]);
+        if (ret)
             goto switch_init_error;
-        }
     }
 
-    // 타이머 초기화
-    timer_setup(&led_timer, led_timer_callback, 0);
+    // 사용자 공간 프레임 링과 /dev/ledctlN
+    panel->stream_ring = vmalloc_user(PAGE_ALIGN(LEDCTL_RING_SIZE));
+    if (!panel->stream_ring) {
+        ret = -ENOMEM;
+        goto switch_init_error;
+    }
+    panel->stream_ring->size = LEDCTL_RING_FRAMES;
+
+    snprintf(panel->misc_name, sizeof(panel->misc_name), "ledctl%d", panel->id);
+    panel->misc.minor = MISC_DYNAMIC_MINOR;
+    panel->misc.name = panel->misc_name;
+    panel->misc.fops = &ledctl_fops;
+    panel->misc.parent = dev;
+    ret = misc_register(&panel->misc);
+    if (ret) {
+        dev_err(dev, "Failed to register /dev/%s\n", panel->misc_name);
+        goto switch_init_error;
+    }
+
+    // 지정된 밝기로 PWM 엔진 시작
+    write_seqlock_irq(&panel->lock);
+    pwm_apply(panel);
+    write_sequnlock_irq(&panel->lock);
+    led_flush(panel);
 
-    printk(KERN_INFO "LED Control Module Initialized Successfully\n");
+    // "wakeup-source" 가 있으면 스위치로 시스템을 깨울 수 있음 (power/wakeup 으로 끄고 켬)
+    if (device_property_read_bool(dev, "wakeup-source"))
+        device_init_wakeup(dev, true);
+
+    // 런타임 PM: 처음에는 유휴 (모드 -1, 전체 소등) 라 지연 뒤 autosuspend
+    pm_runtime_set_autosuspend_delay(dev, LED_AUTOSUSPEND_MS);
+    pm_runtime_use_autosuspend(dev);
+    pm_runtime_get_noresume(dev);
+    pm_runtime_set_active(dev);
+    pm_runtime_enable(dev);
+    pm_runtime_mark_last_busy(dev);
+    pm_runtime_put_autosuspend(dev);
+
+    led_panel_debugfs_init(panel);
+
+    dev_info(dev, "LED panel %d initialized (%d LEDs, %s output)\n",
+             panel->id, num_leds, out->name);
     return 0;
 
 // 오류 발생 시 정리를 위한 레이블
 switch_init_error:
-    // 스위치 IRQ와 GPIO 해제
+    // 준비를 마친 스위치만 멈춤: IRQ 와 핀은 이 함수가 돌아간 뒤 devm 이 역순으로 반납
     while (i--) {
-        free_irq(irq_numbers[i], (void *)(long)i);
-        gpio_free(switch_pins[i]);
-    }
-    
-    // LED GPIO 해제
-    for (i = 0; i < NUM_LEDS; i++) {
-        gpio_free(led_pins[i]);
+        switch_quiesce(&panel->switches[i]);
     }
+    // 이미 눌린 스위치가 타이머와 런타임 PM 참조를 잡았을 수 있음
+    cancel_work_sync(&panel->kick_work);
+    led_timer_cancel(panel);
+    if (panel->pm_busy)
+        pm_runtime_put_noidle(dev);
+    out->release(panel);
     return ret;
+}
 
-led_init_error:
-    // LED GPIO 해제
-    while (i--) {
-        gpio_free(led_pins[i]);
+static void led_panel_remove(struct led_panel *panel) {
+    int i;
+
+    // 정리하는 동안 autosuspend 가 끼어들지 않도록 깨워 둠
+    pm_runtime_get_sync(panel->dev);
+
+    // 사용자 공간 제어 경로와 IRQ 를 먼저 해제해야 타이머를 다시 걸지 않음
+    led_panel_debugfs_exit(panel);
+    misc_deregister(&panel->misc);
+    write_seqlock_irq(&panel->lock);
+    panel->dead = true;
+    write_sequnlock_irq(&panel->lock);
+
+    for (i = 0; i < NUM_SWITCHES; i++) {
+        switch_quiesce(&panel->switches[i]);
     }
-    return ret;
+    device_init_wakeup(panel->dev, false);
+
+    // 타이머 제거 (시작 워크와 명령 워크가 타이머를 다시 걸지 않도록 먼저 비움)
+    cancel_work_sync(&panel->cmd_work);
+    cancel_work_sync(&panel->kick_work);
+    led_timer_cancel(panel);
+    write_seqlock_irq(&panel->lock);
+    panel->pwm.num_edges = 0;
+    panel->fade.duration_us = 0;
+    panel->fade.active = false;
+    write_sequnlock_irq(&panel->lock);
+    hrtimer_cancel(&panel->pwm_timer);
+
+    write_seqlock_irq(&panel->lock);
+    reset_leds(panel);
+    if (panel->pm_busy) {
+        panel->pm_busy = false;
+        pm_runtime_put_noidle(panel->dev);
+    }
+    write_sequnlock_irq(&panel->lock);
+    led_flush(panel);
+    panel->out->release(panel);
+
+    pm_runtime_disable(panel->dev);
+    pm_runtime_dont_use_autosuspend(panel->dev);
+    pm_runtime_put_noidle(panel->dev);
+
+    // IRQ 와 핀은 이 함수가 끝난 뒤 devm 이 반납하고, 마지막으로 led_panel_put 이 probe 의 참조를 놓음
+    // 열린 /dev/ledctlN 이 남아 있으면 마지막 close 에서 해제
+    dev_info(panel->dev, "LED panel %d removed\n", panel->id);
 }
 
-static void __exit led_module_exit(void) {
-    int i;
+// PWM 타이머를 멈추고 출력을 끔 (프로세스 컨텍스트)
+// 프레임 상태 (state.leds, level) 는 그대로 두고 PWM 위상만 비워 어두운 프레임을 냄
+// 실행 중인 PWM 콜백이 위상을 되살리지 않도록 타이머를 먼저 멈춘 뒤 출력
+static void led_pwm_park(struct led_panel *panel) {
+    write_seqlock_irq(&panel->lock);
+    panel->pm_parked = true;
+    clear_bit(LED_KICK_PWM, &panel->kick);
+    write_sequnlock_irq(&panel->lock);
+    hrtimer_cancel(&panel->pwm_timer);
+
+    write_seqlock_irq(&panel->lock);
+    bitmap_zero(panel->pwm.phase, panel->num_leds);
+    led_commit(panel);
+    write_sequnlock_irq(&panel->lock);
+    led_flush(panel);
+    // 하드웨어 PWM 채널도 꺼진 프레임을 반영한 뒤 멈춤
+    flush_work(&panel->hwpwm.work);
+}
+
+// PWM 엔진을 다시 시작하고 저장된 프레임을 출력 (panel->lock 쓰기 구간 안에서 호출)
+static void led_pwm_unpark(struct led_panel *panel) {
+    panel->pm_parked = false;
+    pwm_apply(panel);
+}
+
+// 유휴 패널: 패턴 타이머는 이미 멈춰 있으므로 PWM 타이머만 멈춤
+// 페이드아웃이 남아 있으면 끝날 때까지 미룸 (RPM_AUTO 라 만료 시각을 다시 계산해 재시도)
+static int led_panel_runtime_suspend(struct device *dev) {
+    struct led_panel *panel = dev_get_drvdata(dev);
+    bool fading;
+
+    write_seqlock_irq(&panel->lock);
+    fading = panel->fade.active;
+    write_sequnlock_irq(&panel->lock);
+    if (fading) {
+        pm_runtime_mark_last_busy(dev);
+        return -EBUSY;
+    }
+
+    led_pwm_park(panel);
+    return 0;
+}
+
+static int led_panel_runtime_resume(struct device *dev) {
+    struct led_panel *panel = dev_get_drvdata(dev);
+
+    write_seqlock_irq(&panel->lock);
+    led_pwm_unpark(panel);
+    write_sequnlock_irq(&panel->lock);
+    led_flush(panel);
+    return 0;
+}
 
-    // 타이머 제거
-    del_timer_sync(&led_timer);
+// 시스템 suspend: 스위치 IRQ 를 먼저 막고 (스레드가 타이머를 다시 걸지 않도록) 타이머와 워크를 정지
+// 패턴 위치와 LED 상태는 panel 에 그대로 남아 resume 에서 이어서 재생
+// 깨움이 허용되어 있으면 (power/wakeup) 스위치 IRQ 는 막지 않고 깨움 소스로 둠
+static int led_panel_suspend(struct device *dev) {
+    struct led_panel *panel = dev_get_drvdata(dev);
+    bool wake = device_may_wakeup(dev);
+    int i;
 
-    // IRQ와 GPIO 안전하게 해제
     for (i = 0; i < NUM_SWITCHES; i++) {
-        free_irq(irq_numbers[i], (void *)(long)i);
-        gpio_free(switch_pins[i]);
+        struct led_switch *sw = &panel->switches[i];
+
+        sw->wake_armed = wake && !enable_irq_wake(sw->irq);
+        if (sw->wake_armed)
+            continue;
+        disable_irq(sw->irq);
+        // 열려 있던 디바운스 구간도 IRQ 를 한 번 꺼 둔 상태: 콜백 대신 켜서 깊이를 1 로 맞춤
+        // 떼어짐을 보지 못했으므로 resume 뒤 첫 누름이 새 누름으로 잡히도록 레벨도 초기화
+        if (hrtimer_cancel(&sw->debounce_timer)) {
+            sw->pressed = false;
+            clear_bit(LED_SW_WAKE_REPORTED, &sw->wake);
+            enable_irq(sw->irq);
+        }
     }
 
-    for (i = 0; i < NUM_LEDS; i++) {
-        gpio_set_value(led_pins[i], 0);
-        gpio_free(led_pins[i]);
+    write_seqlock_irq(&panel->lock);
+    panel->suspended = true;
+    panel->pm_ticking = sync_tick ? panel->sync_running
+                                  : hrtimer_is_queued(&panel->led_timer) ||
+                                    test_bit(LED_KICK_TIMER, &panel->kick);
+    led_timer_stop(panel);
+    write_sequnlock_irq(&panel->lock);
+
+    cancel_work_sync(&panel->cmd_work);
+    cancel_work_sync(&panel->kick_work);
+    if (!sync_tick)
+        hrtimer_cancel(&panel->led_timer);
+
+    // 런타임 suspend 상태였다면 PWM 은 이미 멈춰 있음
+    if (!pm_runtime_status_suspended(dev))
+        led_pwm_park(panel);
+    return 0;
+}
+
+// resume: 출력을 되살리고 패턴 타이머는 지금부터 새 주기로 (sync_tick 이면 다음 격자 틱에) 다시 맞춤
+static int led_panel_resume(struct device *dev) {
+    struct led_panel *panel = dev_get_drvdata(dev);
+    int i;
+
+    write_seqlock_irq(&panel->lock);
+    panel->suspended = false;
+    if (!pm_runtime_status_suspended(dev))
+        led_pwm_unpark(panel);
+    if (panel->pm_ticking)
+        led_timer_start(panel);
+    write_sequnlock_irq(&panel->lock);
+    led_flush(panel);
+
+    for (i = 0; i < NUM_SWITCHES; i++) {
+        struct led_switch *sw = &panel->switches[i];
+
+        if (!sw->wake_armed) {
+            enable_irq(sw->irq);
+            continue;
+        }
+        disable_irq_wake(sw->irq);
+        sw->wake_armed = false;
+        // 시스템을 깨운 누름: 바운스가 몇 번이었든 스레드 한 번, 사용자 공간 이벤트 하나
+        if (test_and_clear_bit(LED_SW_WAKE_PENDING, &sw->wake))
+            irq_wake_thread(sw->irq, sw);
     }
 
-    mutex_destroy(&mode_lock);
+    // suspend 중에 쌓인 명령
+    if (!kfifo_is_empty(&panel->cmds))
+        queue_work(system_highpri_wq, &panel->cmd_work);
+    return 0;
+}
+
+static const struct dev_pm_ops led_panel_pm_ops = {
+    SYSTEM_SLEEP_PM_OPS(led_panel_suspend, led_panel_resume)
+    RUNTIME_PM_OPS(led_panel_runtime_suspend, led_panel_runtime_resume, NULL)
+};
+
+static int led_panel_platform_probe(struct platform_device *pdev) {
+    return led_panel_probe(&pdev->dev, &led_gpio_ops);
+}
+
+static int led_panel_platform_remove(struct platform_device *pdev) {
+    led_panel_remove(platform_get_drvdata(pdev));
+    return 0;
+}
+
+static const struct of_device_id led_panel_of_match[] = {
+    { .compatible = "bdlee,led-panel" },
+    { }
+};
+MODULE_DEVICE_TABLE(of, led_panel_of_match);
+
+static struct platform_driver led_panel_driver = {
+    .probe = led_panel_platform_probe,
+    .remove = led_panel_platform_remove,
+    .driver = {
+        .name = "led-panel",
+        .probe_type = PROBE_PREFER_ASYNCHRONOUS,
+        .of_match_table = led_panel_of_match,
+        .dev_groups = led_panel_groups,
+        .pm = pm_ptr(&led_panel_pm_ops),
+    },
+};
+
+// 칩 종류는 compatible (또는 spi_device_id) 의 데이터로 구분
+static int led_panel_spi_probe(struct spi_device *spi) {
+    const struct led_output_ops *out = device_get_match_data(&spi->dev);
+
+    if (!out)
+        out = (const struct led_output_ops *)spi_get_device_id(spi)->driver_data;
+    return led_panel_probe(&spi->dev, out);
+}
+
+static void led_panel_spi_remove(struct spi_device *spi) {
+    led_panel_remove(spi_get_drvdata(spi));
+}
+
+static const struct of_device_id led_panel_spi_of_match[] = {
+    { .compatible = "bdlee,led-panel-595", .data = &led_595_ops },
+    { .compatible = "bdlee,led-panel-ws2812", .data = &led_ws2812_ops },
+    { .compatible = "bdlee,led-panel-apa102", .data = &led_apa102_ops },
+    { }
+};
+MODULE_DEVICE_TABLE(of, led_panel_spi_of_match);
+
+static const struct spi_device_id led_panel_spi_ids[] = {
+    { "led-panel-595", (kernel_ulong_t)&led_595_ops },
+    { "led-panel-ws2812", (kernel_ulong_t)&led_ws2812_ops },
+    { "led-panel-apa102", (kernel_ulong_t)&led_apa102_ops },
+    { }
+};
+MODULE_DEVICE_TABLE(spi, led_panel_spi_ids);
+
+static struct spi_driver led_panel_spi_driver = {
+    .probe = led_panel_spi_probe,
+    .remove = led_panel_spi_remove,
+    .id_table = led_panel_spi_ids,
+    .driver = {
+        .name = "led-panel-spi",
+        .probe_type = PROBE_PREFER_ASYNCHRONOUS,
+        .of_match_table = led_panel_spi_of_match,
+        .dev_groups = led_panel_groups,
+        .pm = pm_ptr(&led_panel_pm_ops),
+    },
+};
+
+static int __init led_module_init(void) {
+    int ret;
+
+    ws2812_lut_init();
+    led_gamma_init();
+    hrtimer_init(&led_sync_timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+    led_sync_timer.function = led_sync_timer_callback;
+    INIT_WORK(&led_sync_kick_work, led_sync_kick_fn);
+    led_debugfs_init();
 
-    printk(KERN_INFO "LED Control Module Safely Exited\n");
+    ret = platform_driver_register(&led_panel_driver);
+    if (ret)
+        goto debugfs_remove;
+
+    ret = spi_register_driver(&led_panel_spi_driver);
+    if (ret)
+        goto platform_unregister;
+    return 0;
+
+platform_unregister:
+    platform_driver_unregister(&led_panel_driver);
+debugfs_remove:
+    led_debugfs_exit();
+    return ret;
+}
+
+static void __exit led_module_exit(void) {
+    spi_unregister_driver(&led_panel_spi_driver);
+    platform_driver_unregister(&led_panel_driver);
+    cancel_work_sync(&led_sync_kick_work);
+    hrtimer_cancel(&led_sync_timer);
+    led_debugfs_exit();
 }
 
 module_init(led_module_init);
 module_exit(led_module_exit);
-
 MODULE_LICENSE("GPL");
@@ -0,0 +1,141 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+// LED 패널 tracepoint (tracefs 의 events/led_panel/)
+// 예: echo 1 > /sys/kernel/tracing/events/led_panel/led_tick/enable
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM led_panel
+
+#if !defined(_LED_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _LED_TRACE_H
+
+#include <linux/tracepoint.h>
+#include <linux/ktime.h>
+
+// 스위치 한 개에 대한 이벤트: 하드 IRQ/스레드 진입과 종료, 디바운스에서 버린 엣지
+DECLARE_EVENT_CLASS(led_switch_class,
+    TP_PROTO(int panel, int sw),
+    TP_ARGS(panel, sw),
+
+    TP_STRUCT__entry(
+        __field(int, panel)
+        __field(int, sw)
+    ),
+
+    TP_fast_assign(
+        __entry->panel = panel;
+        __entry->sw = sw;
+    ),
+
+    TP_printk("panel=%d switch=%d", __entry->panel, __entry->sw)
+);
+
+DEFINE_EVENT(led_switch_class, led_switch_irq_entry,
+    TP_PROTO(int panel, int sw),
+    TP_ARGS(panel, sw)
+);
+
+DEFINE_EVENT(led_switch_class, led_switch_irq_exit,
+    TP_PROTO(int panel, int sw),
+    TP_ARGS(panel, sw)
+);
+
+DEFINE_EVENT(led_switch_class, led_switch_thread_entry,
+    TP_PROTO(int panel, int sw),
+    TP_ARGS(panel, sw)
+);
+
+DEFINE_EVENT(led_switch_class, led_switch_thread_exit,
+    TP_PROTO(int panel, int sw),
+    TP_ARGS(panel, sw)
+);
+
+DEFINE_EVENT(led_switch_class, led_debounce_drop,
+    TP_PROTO(int panel, int sw),
+    TP_ARGS(panel, sw)
+);
+
+TRACE_EVENT(led_mode_change,
+    TP_PROTO(int panel, int sw, int old_mode, int new_mode),
+    TP_ARGS(panel, sw, old_mode, new_mode),
+
+    TP_STRUCT__entry(
+        __field(int, panel)
+        __field(int, sw)
+        __field(int, old_mode)
+        __field(int, new_mode)
+    ),
+
+    TP_fast_assign(
+        __entry->panel = panel;
+        __entry->sw = sw;
+        __entry->old_mode = old_mode;
+        __entry->new_mode = new_mode;
+    ),
+
+    TP_printk("panel=%d switch=%d mode=%d->%d",
+              __entry->panel, __entry->sw, __entry->old_mode, __entry->new_mode)
+);
+
+// 타이머 콜백 한 번: 예정 만료 시각과 실제 실행 시각 (late 가 지터)
+DECLARE_EVENT_CLASS(led_tick_class,
+    TP_PROTO(int panel, ktime_t scheduled, ktime_t actual),
+    TP_ARGS(panel, scheduled, actual),
+
+    TP_STRUCT__entry(
+        __field(int, panel)
+        __field(s64, scheduled)
+        __field(s64, actual)
+    ),
+
+    TP_fast_assign(
+        __entry->panel = panel;
+        __entry->scheduled = ktime_to_ns(scheduled);
+        __entry->actual = ktime_to_ns(actual);
+    ),
+
+    TP_printk("panel=%d scheduled=%lld actual=%lld late=%lldns",
+              __entry->panel, __entry->scheduled, __entry->actual,
+              __entry->actual - __entry->scheduled)
+);
+
+DEFINE_EVENT(led_tick_class, led_tick,
+    TP_PROTO(int panel, ktime_t scheduled, ktime_t actual),
+    TP_ARGS(panel, scheduled, actual)
+);
+
+DEFINE_EVENT(led_tick_class, led_pwm_tick,
+    TP_PROTO(int panel, ktime_t scheduled, ktime_t actual),
+    TP_ARGS(panel, scheduled, actual)
+);
+
+// 백엔드로 프레임 하나를 출력하는 데 걸린 시간
+TRACE_EVENT(led_commit,
+    TP_PROTO(int panel, const char *backend, int num_leds, u64 duration_ns),
+    TP_ARGS(panel, backend, num_leds, duration_ns),
+
+    TP_STRUCT__entry(
+        __field(int, panel)
+        __string(backend, backend)
+        __field(int, num_leds)
+        __field(u64, duration_ns)
+    ),
+
+    TP_fast_assign(
+        __entry->panel = panel;
+        __assign_str(backend, backend);
+        __entry->num_leds = num_leds;
+        __entry->duration_ns = duration_ns;
+    ),
+
+    TP_printk("panel=%d backend=%s leds=%d duration=%lluns",
+              __entry->panel, __get_str(backend), __entry->num_leds, __entry->duration_ns)
+);
+
+#endif /* _LED_TRACE_H */
+
+// 이 헤더는 모듈 소스 디렉터리에 있으므로 Makefile 에서 -I$(src) 필요
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE led_trace
+#include <trace/define_trace.h>
@@ -0,0 +1,335 @@
+// LED 패널 지연 측정 도구: 스위치 눌림을 반복 주입하고 엣지 -> LED 지연, 틱 지터, CPU 시간을 보고
+// make ledbench (또는 gcc -O2 -Wall -o ledbench ledbench.c)
+//
+// 주입 방법 (둘 중 하나)
+//   debugfs (기본): /sys/kernel/debug/led_panel/panelN/inject 에 스위치 번호를 씀 (계측 빌드만)
+//   GPIO loopback (-g): 출력 GPIO 를 스위치 입력에 점퍼로 연결하고 그 라인을 토글
+//
+// 소프트웨어 디바운스를 쓰면 지연에 debounce_us 가 그대로 더해지고 그 사이 엣지는 버려지므로
+// 주입 간격 (-i) 은 debounce_us 보다 충분히 길게
+// 엣지 -> LED 는 커널이 이벤트에 넣어 주는 엣지 시각과 출력 반영 시각의 차이
+// -l 로 엣지 -> LED p99 상한을 주면 초과 시 종료 코드 1 (릴리스 판정용)
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <linux/gpio.h>
+
+#include "ledctl.h"
+
+#define EVENT_TIMEOUT_MS 1000
+#define MAX_STATS 256  // debugfs stats 의 "이름 값" 줄 수 상한
+#define DIAG_PATH "/sys/kernel/debug/led_panel/diagnostics"
+
+struct stat_line {
+    char name[48];
+    unsigned long long value;
+};
+
+struct stats {
+    struct stat_line lines[MAX_STATS];
+    int n;
+};
+
+// /proc/stat 의 전체 CPU 줄: 커널 쪽 (system + irq + softirq) 시간
+struct cpu_times {
+    unsigned long long system, irq, softirq;
+};
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int read_stats(const char *path, struct stats *st) {
+    FILE *f = fopen(path, "r");
+
+    if (!f)
+        return -1;
+    st->n = 0;
+    while (st->n < MAX_STATS &&
+           fscanf(f, "%47s %llu", st->lines[st->n].name, &st->lines[st->n].value) == 2)
+        st->n++;
+    fclose(f);
+    return 0;
+}
+
+static unsigned long long stat_value(const struct stats *st, const char *name) {
+    int i;
+
+    for (i = 0; i < st->n; i++) {
+        if (!strcmp(st->lines[i].name, name))
+            return st->lines[i].value;
+    }
+    return 0;
+}
+
+static int read_cpu_times(struct cpu_times *t) {
+    unsigned long long user, nice, idle, iowait;
+    FILE *f = fopen("/proc/stat", "r");
+    int n;
+
+    if (!f)
+        return -1;
+    n = fscanf(f, "cpu %llu %llu %llu %llu %llu %llu %llu",
+               &user, &nice, &t->system, &idle, &iowait, &t->irq, &t->softirq);
+    fclose(f);
+    return n == 7 ? 0 : -1;
+}
+
+// 커널 통계 수집 스위치를 value 로 바꾸고 이전 값을 돌려줌 (-1: 없음)
+static int set_diag(int value) {
+    char old = 0, buf[2] = { value ? '1' : '0', '\n' };
+    int fd = open(DIAG_PATH, O_RDWR);
+
+    if (fd < 0)
+        return -1;
+    if (read(fd, &old, 1) != 1 || pwrite(fd, buf, sizeof(buf), 0) != sizeof(buf))
+        old = 0;
+    close(fd);
+    return old ? old == '1' : -1;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+// 정렬된 표본의 백분위 (최근접 순위)
+static uint64_t percentile(const uint64_t *v, int n, double p) {
+    int i = (int)(p / 100.0 * n + 0.5);
+
+    if (i < 1)
+        i = 1;
+    if (i > n)
+        i = n;
+    return v[i - 1];
+}
+
+static void report(const char *name, uint64_t *v, int n) {
+    if (!n)
+        return;
+    qsort(v, n, sizeof(*v), cmp_u64);
+    printf("%-14s min %8.1f  p50 %8.1f  p90 %8.1f  p99 %8.1f  p99.9 %8.1f  max %8.1f us\n",
+           name, v[0] / 1e3, percentile(v, n, 50) / 1e3, percentile(v, n, 90) / 1e3,
+           percentile(v, n, 99) / 1e3, percentile(v, n, 99.9) / 1e3, v[n - 1] / 1e3);
+}
+
+// GPIO loopback: 출력 라인 하나를 v2 uapi 로 요청
+static int gpio_open(const char *spec) {
+    struct gpio_v2_line_request req;
+    char chip[64];
+    unsigned int line;
+    int fd, ret;
+
+    if (sscanf(spec, "%63[^:]:%u", chip, &line) != 2) {
+        fprintf(stderr, "-g expects /dev/gpiochipN:line\n");
+        return -1;
+    }
+    fd = open(chip, O_RDWR);
+    if (fd < 0) {
+        perror(chip);
+        return -1;
+    }
+
+    memset(&req, 0, sizeof(req));
+    req.offsets[0] = line;
+    req.num_lines = 1;
+    req.config.flags = GPIO_V2_LINE_FLAG_OUTPUT;
+    strcpy(req.consumer, "ledbench");
+    ret = ioctl(fd, GPIO_V2_GET_LINE_IOCTL, &req);
+    close(fd);
+    if (ret < 0) {
+        perror("GPIO_V2_GET_LINE_IOCTL");
+        return -1;
+    }
+    return req.fd;
+}
+
+static int gpio_set(int fd, int value) {
+    struct gpio_v2_line_values v = { .bits = value, .mask = 1 };
+
+    return ioctl(fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &v);
+}
+
+static int inject(int inject_fd, int gpio_fd, int sw) {
+    char buf[8];
+    int len;
+
+    if (gpio_fd >= 0)
+        return gpio_set(gpio_fd, 1);
+    len = snprintf(buf, sizeof(buf), "%d\n", sw);
+    return pwrite(inject_fd, buf, len, 0) == len ? 0 : -1;
+}
+
+// 주어진 스위치의 이벤트가 올 때까지 대기 (다른 스위치의 이벤트는 건너뜀)
+static int wait_event(int fd, int sw, struct ledctl_event *ev) {
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    uint64_t deadline = now_ns() + EVENT_TIMEOUT_MS * 1000000ULL;
+    uint64_t t;
+
+    for (;;) {
+        t = now_ns();
+        if (t >= deadline)
+            return -1;
+        if (poll(&pfd, 1, (deadline - t) / 1000000 + 1) <= 0)
+            return -1;
+        if (read(fd, ev, sizeof(*ev)) != sizeof(*ev))
+            return -1;
+        if ((int)ev->switch_id == sw)
+            return 0;
+    }
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "usage: %s [-p panel] [-n count] [-s switch] [-i interval_us] "
+            "[-g /dev/gpiochipN:line] [-l p99_limit_us]\n", prog);
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    int panel = 0, count = 1000, sw = 2, interval_us = 50000, gpio_fd = -1, inject_fd = -1;
+    const char *gpio_spec = NULL;
+    double limit_us = 0;
+    char path[128], stats_path[128];
+    struct stats before, after;
+    struct cpu_times cpu0, cpu1;
+    struct rusage ru;
+    struct ledctl_event ev;
+    uint64_t *led_lat, *edge_lat, *send_lat, t0, t1, late0, late1, ticks;
+    int fd, opt, i, n = 0, missed = 0, have_stats, have_cpu, diag, rc = 0;
+    long hz = sysconf(_SC_CLK_TCK);
+
+    while ((opt = getopt(argc, argv, "p:n:s:i:g:l:")) != -1) {
+        switch (opt) {
+            case 'p': panel = atoi(optarg); break;
+            case 'n': count = atoi(optarg); break;
+            case 's': sw = atoi(optarg); break;
+            case 'i': interval_us = atoi(optarg); break;
+            case 'g': gpio_spec = optarg; break;
+            case 'l': limit_us = atof(optarg); break;
+            default: usage(argv[0]);
+        }
+    }
+    if (count < 1 || sw < 0 || sw > 3 || interval_us < 0)
+        usage(argv[0]);
+
+    snprintf(path, sizeof(path), "/dev/ledctl%d", panel);
+    fd = open(path, O_RDONLY | O_NONBLOCK);
+    if (fd < 0) {
+        perror(path);
+        return 1;
+    }
+
+    if (gpio_spec) {
+        gpio_fd = gpio_open(gpio_spec);
+        if (gpio_fd < 0)
+            return 1;
+    } else {
+        snprintf(path, sizeof(path), "/sys/kernel/debug/led_panel/panel%d/inject", panel);
+        inject_fd = open(path, O_WRONLY);
+        if (inject_fd < 0) {
+            perror(path);
+            return 1;
+        }
+    }
+
+    led_lat = calloc(count, sizeof(*led_lat));
+    edge_lat = calloc(count, sizeof(*edge_lat));
+    send_lat = calloc(count, sizeof(*send_lat));
+    if (!led_lat || !edge_lat || !send_lat)
+        return 1;
+
+    snprintf(stats_path, sizeof(stats_path), "/sys/kernel/debug/led_panel/panel%d/stats", panel);
+    // 통계는 측정하는 동안만 켜고 끝나면 원래대로
+    diag = set_diag(1);
+    have_stats = !read_stats(stats_path, &before);
+    have_cpu = !read_cpu_times(&cpu0);
+
+    for (i = 0; i < count; i++) {
+        t0 = now_ns();
+        if (inject(inject_fd, gpio_fd, sw)) {
+            perror("inject");
+            return 1;
+        }
+        if (wait_event(fd, sw, &ev)) {
+            missed++;
+        } else {
+            t1 = now_ns();
+            // 이벤트 시각은 하드 IRQ 에서 찍은 엣지 시각 (같은 CLOCK_MONOTONIC)
+            led_lat[n] = ev.commit_ns - ev.timestamp_ns;
+            edge_lat[n] = t1 - ev.timestamp_ns;
+            send_lat[n] = t1 - t0;
+            n++;
+        }
+        if (gpio_fd >= 0)
+            gpio_set(gpio_fd, 0);
+        if (interval_us)
+            usleep(interval_us);
+    }
+
+    printf("presses %d, events %d, missed %d\n", count, n, missed);
+    report("edge->led", led_lat, n);
+    report("edge->event", edge_lat, n);
+    report("inject->event", send_lat, n);
+
+    if (have_stats && !read_stats(stats_path, &after)) {
+        ticks = stat_value(&after, "ticks") - stat_value(&before, "ticks");
+        late0 = stat_value(&before, "tick_late_sum_ns");
+        late1 = stat_value(&after, "tick_late_sum_ns");
+        if (ticks)
+            printf("ticks %llu, avg late %.1f us, max late (since load) %.1f us\n",
+                   (unsigned long long)ticks, (double)(late1 - late0) / ticks / 1e3,
+                   stat_value(&after, "tick_late_max_ns") / 1e3);
+
+        // 커널 쪽 카운터와 히스토그램은 이번 실행 동안 늘어난 만큼만
+        printf("kernel stats delta:\n");
+        for (i = 0; i < after.n; i++) {
+            const char *name = after.lines[i].name;
+            unsigned long long d = after.lines[i].value - stat_value(&before, name);
+
+            if (d && strncmp(name, "tick_late_", 10))
+                printf("  %-28s %llu\n", name, d);
+        }
+    }
+
+    if (have_cpu && !read_cpu_times(&cpu1))
+        printf("kernel cpu: system %.1f ms, irq %.1f ms, softirq %.1f ms (all CPUs)\n",
+               (cpu1.system - cpu0.system) * 1e3 / hz, (cpu1.irq - cpu0.irq) * 1e3 / hz,
+               (cpu1.softirq - cpu0.softirq) * 1e3 / hz);
+    if (!getrusage(RUSAGE_SELF, &ru))
+        printf("ledbench cpu: user %.1f ms, sys %.1f ms\n",
+               ru.ru_utime.tv_sec * 1e3 + ru.ru_utime.tv_usec / 1e3,
+               ru.ru_stime.tv_sec * 1e3 + ru.ru_stime.tv_usec / 1e3);
+
+    // report 가 정렬해 두었으므로 바로 백분위
+    if (limit_us > 0 && (missed || (n && percentile(led_lat, n, 99) / 1e3 > limit_us))) {
+        fprintf(stderr, "FAIL: p99 edge->led above %.1f us or missed events\n", limit_us);
+        rc = 1;
+    }
+
+    if (diag >= 0)
+        set_diag(diag);
+    free(send_lat);
+    free(edge_lat);
+    free(led_lat);
+    if (gpio_fd >= 0)
+        close(gpio_fd);
+    if (inject_fd >= 0)
+        close(inject_fd);
+    close(fd);
+    return rc;
+}
@@ -0,0 +1,52 @@
+#ifndef _LEDCTL_H
+#define _LEDCTL_H
+
+// /dev/ledctlN 사용자 공간 인터페이스 (패널마다 하나, 커널 모듈과 사용자 프로그램이 함께 사용)
+
+#include <linux/ioctl.h>
+#include <linux/types.h>
+
+#define LEDCTL_MAX_LEDS 512
+#define LEDCTL_FRAME_WORDS (LEDCTL_MAX_LEDS / 32)
+#define LEDCTL_RING_FRAMES 1024  // 2의 거듭제곱
+
+// 프레임 하나: timestamp_ns (CLOCK_MONOTONIC) 이 지난 뒤 첫 틱에 출력
+struct ledctl_frame {
+    __u64 timestamp_ns;
+    __u32 leds[LEDCTL_FRAME_WORDS];  // LED i 는 leds[i / 32] 의 (i % 32) 번 비트
+};
+
+// mmap 으로 공유되는 단일 생산자/단일 소비자 링
+// head 는 사용자 공간만, tail 은 커널만 증가시킴 (서로 다른 캐시 라인)
+struct ledctl_ring {
+    __u32 head;          // 다음에 쓸 프레임 번호
+    __u32 size;          // 프레임 수 (LEDCTL_RING_FRAMES)
+    __u32 pad0[14];
+    __u32 tail;          // 다음에 읽을 프레임 번호
+    __u32 pad1[15];
+    struct ledctl_frame frames[LEDCTL_RING_FRAMES];
+};
+
+#define LEDCTL_RING_SIZE sizeof(struct ledctl_ring)
+
+// read() 로 받는 스위치 이벤트 (open 마다 별도 큐)
+struct ledctl_event {
+    __u64 timestamp_ns;  // 스위치 엣지 시각 (CLOCK_MONOTONIC)
+    __u32 switch_id;
+    __s32 mode;          // 전환 후 모드
+    __u32 dropped;       // 큐가 가득 차서 이 이벤트 앞에서 버려진 이벤트 수
+    __u32 pad;
+    __u64 commit_ns;     // 전환된 출력을 LED 에 내보낸 시각 (CLOCK_MONOTONIC)
+};
+
+#define LEDCTL_IOC_MAGIC 'L'
+#define LEDCTL_START      _IO(LEDCTL_IOC_MAGIC, 0)         // 링 재생 시작 (모드 4)
+#define LEDCTL_STOP       _IO(LEDCTL_IOC_MAGIC, 1)         // 재생 정지, 마지막 프레임 유지
+#define LEDCTL_SET_PERIOD _IOW(LEDCTL_IOC_MAGIC, 2, __u32)  // 틱 주기 (us)
+#define LEDCTL_SET_MODE   _IOW(LEDCTL_IOC_MAGIC, 3, __u32)  // 모드 0-3 (스위치 0-3 과 같은 동작)
+#define LEDCTL_SET_DIRECTION _IOW(LEDCTL_IOC_MAGIC, 4, __u32)  // 개별 모드 방향 0/1
+
+// START, STOP, SET_MODE, SET_DIRECTION 은 명령 링에 넣고 바로 돌아오며 다음 틱 시작에서 적용
+// 링이 가득 차 있으면 -EAGAIN
+
+#endif /* _LEDCTL_H */